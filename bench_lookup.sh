@@ -0,0 +1,49 @@
+#!/bin/bash
+# 查表吞吐基准的编译和运行脚本
+# 用途：编译 src/bench_lookup 并把参数原样传给它，例如
+#       ./bench_lookup.sh                                   # acl_10k.rules，生成的 trace
+#       ./gen_rules.sh -n 100000 -s 1 -o /tmp/syn_100k.rules
+#       ./bench_lookup.sh -p 100000000 src/ACL_rules/acl_10k.rules /tmp/syn_100k.rules
+
+set -euo pipefail
+
+# 只在子 shell 中切换到脚本目录编译，规则 / trace 路径仍按调用者的当前目录解析
+PROJECT_ROOT="$(cd "$(dirname "$0")" && pwd)"
+
+# 选择可用的编译器，优先 g++-11，其次 g++
+CXX_BIN="${CXX:-g++-11}"
+if ! command -v "$CXX_BIN" >/dev/null 2>&1; then
+    if command -v g++ >/dev/null 2>&1; then
+        CXX_BIN="g++"
+    else
+        echo "✗ 未找到可用的 g++ 编译器，请安装 g++ 或 g++-11" >&2
+        exit 1
+    fi
+fi
+
+SOURCES=(
+    src/bench_lookup.cpp
+    src/TcamLookup.cpp
+    src/TcamBitSlice.cpp
+    src/CGFE_code.cpp
+    src/Gray_code.cpp
+    src/Chunk_code.cpp
+    src/Loader.cpp
+    src/Snapshot.cpp
+    src/TcamWriter.cpp
+)
+
+# 任一源文件或头文件比二进制新时才重新编译
+(
+    cd "$PROJECT_ROOT"
+    stale=0
+    [ -x src/bench_lookup ] || stale=1
+    for f in "${SOURCES[@]}" src/*.hpp; do
+        [ "$f" -nt src/bench_lookup ] && stale=1
+    done
+    if [ "$stale" = 1 ]; then
+        "$CXX_BIN" -std=c++17 -O2 "${SOURCES[@]}" -pthread -o src/bench_lookup >&2
+    fi
+)
+
+"$PROJECT_ROOT/src/bench_lookup" "$@"
@@ -0,0 +1,33 @@
+#!/bin/bash
+# 合成规则生成器的编译和运行脚本
+# 用途：编译 src/gen_rules 并把参数原样传给它，例如
+#       ./gen_rules.sh -n 10000000 -s 7 -o src/ACL_rules/syn_10m.rules
+
+set -euo pipefail
+
+# 只在子 shell 中切换到脚本目录编译，-o 等相对路径仍按调用者的当前目录解析
+PROJECT_ROOT="$(cd "$(dirname "$0")" && pwd)"
+
+# 选择可用的编译器，优先 g++-11，其次 g++
+CXX_BIN="${CXX:-g++-11}"
+if ! command -v "$CXX_BIN" >/dev/null 2>&1; then
+    if command -v g++ >/dev/null 2>&1; then
+        CXX_BIN="g++"
+    else
+        echo "✗ 未找到可用的 g++ 编译器，请安装 g++ 或 g++-11" >&2
+        exit 1
+    fi
+fi
+
+# 源文件比二进制新时才重新编译
+(
+    cd "$PROJECT_ROOT"
+    if [ ! -x src/gen_rules ] || [ src/gen_rules.cpp -nt src/gen_rules ] || [ src/TcamWriter.cpp -nt src/gen_rules ]; then
+        "$CXX_BIN" -std=c++17 -O2 \
+            src/gen_rules.cpp \
+            src/TcamWriter.cpp \
+            -o src/gen_rules >&2
+    fi
+)
+
+"$PROJECT_ROOT/src/gen_rules" "$@"
@@ -39,7 +39,12 @@ echo "[2/5] 编译 ($CXX_BIN -std=c++17)..."
     src/Gray_code.cpp \
     src/Chunk_code.cpp \
     src/Loader.cpp \
-    -o src/CGFE 2>&1
+    src/Snapshot.cpp \
+    src/TcamWriter.cpp \
+    src/Reload.cpp \
+    src/TcamLookup.cpp \
+    src/TcamBitSlice.cpp \
+    -pthread -o src/CGFE 2>&1
 echo "✓ 编译成功"
 echo ""
 
@@ -12,11 +12,16 @@
 #include <cstdint>
 #include <cassert>
 #include <algorithm>
-#include <iomanip>
-#include <fstream>
+#include <unordered_map>
+#include <stdexcept>
+#include <mutex>
+#include <atomic>
 
 #include "CGFE_code.hpp"
+#include "Fence.hpp"
 #include "Loader.hpp"
+#include "Parallel.hpp"
+#include "TcamWriter.hpp"
 
 using namespace std;
 
@@ -25,15 +30,15 @@ using namespace std;
 // ===============================================================================
 
 int cgfe_msc(uint16_t x, const CGFEConfig& config) {
-    return x / config.block_size();
+    return x >> config.tc_bits();
 }
 
 int cgfe_tc(uint16_t x, const CGFEConfig& config) {
-    return x % config.block_size();
+    return x & (config.block_size() - 1);
 }
 
 uint16_t block_start(int msc, const CGFEConfig& config) {
-    return msc * config.block_size();
+    return msc << config.tc_bits();
 }
 
 uint16_t block_end(int msc, const CGFEConfig& config) {
@@ -45,72 +50,23 @@ uint16_t block_end(int msc, const CGFEConfig& config) {
 // ===============================================================================
 
 /**
- * fence_encode_value: Encode a single c-bit value
- * 
- * F(value) = '0'^(2^c - 1 - value) + '1'^value
- * Output length: 2^c - 1 bits
- */
-static string fence_encode_value(int value, int c) {
-    int max_val = 1 << c;  // 2^c
-    int encoded_len = max_val - 1;  // 2^c - 1
-    
-    int num_zeros = max_val - 1 - value;
-    int num_ones = value;
-    
-    string result;
-    result.reserve(encoded_len);
-    
-    for (int i = 0; i < num_zeros; i++) result += '0';
-    for (int i = 0; i < num_ones; i++) result += '1';
-    
-    return result;
-}
-
-/**
- * fence_encode_range: Encode a range [start, end] within one chunk
+ * Fence chunks are packed value/mask words (see Fence.hpp):
  * 
+ * F(value)  = '0'^(2^c - 1 - value) + '1'^value
  * F([s, e]) = '0'^(2^c - 1 - e) + '*'^(e - s) + '1'^s
  * Output length: 2^c - 1 bits
+ * 
+ * Working patterns hold up to W = 32 bits of CGFE output for a given c.
  */
-static string fence_encode_range(int start, int end, int c) {
-    assert(start <= end);
-    
-    int max_val = 1 << c;  // 2^c
-    int encoded_len = max_val - 1;  // 2^c - 1
-    
-    int num_zeros = max_val - 1 - end;
-    int num_stars = end - start;
-    int num_ones = start;
-    
-    string result;
-    result.reserve(encoded_len);
-    
-    for (int i = 0; i < num_zeros; i++) result += '0';
-    for (int i = 0; i < num_stars; i++) result += '*';
-    for (int i = 0; i < num_ones; i++) result += '1';
-    
-    return result;
-}
+template <int c>
+using CGFEWork = Ternary<(32 / c) * fence_len(c)>;
 
 /**
- * fence_decode_range: Decode a fence-encoded string back to [start, end]
+ * Generate all-star tail
  */
-static pair<int, int> fence_decode_range(const string& enc, int c) {
-    int max_val = 1 << c;
-    int expected_len = max_val - 1;
-    
-    if ((int)enc.length() != expected_len) return {-1, -1};
-    
-    int num_zeros = 0;
-    while (num_zeros < (int)enc.length() && enc[num_zeros] == '0') num_zeros++;
-    
-    int num_ones = 0;
-    while (num_ones < (int)enc.length() && enc[enc.length() - 1 - num_ones] == '1') num_ones++;
-    
-    int start = num_ones;
-    int end = max_val - 1 - num_zeros;
-    
-    return {start, end};
+template <int c>
+static CGFEWork<c> generate_star_tail(int w) {
+    return CGFEWork<c>::any(((w - c) / c) * fence_len(c));
 }
 
 // ===============================================================================
@@ -121,44 +77,39 @@ static pair<int, int> fence_decode_range(const string& enc, int c) {
  * cgfe_encode_value_internal: Encode a single w-bit value
  * 
  * KEY: When MSC is odd, flip the first chunk of the tail encoding
+ * (flip = bit-reverse and complement of the packed chunk)
  */
-static string cgfe_encode_value_internal(int x, int w, int c) {
+static FencePattern cgfe_encode_value_internal(int x, int w, int c) {
     // Base case: single chunk
     if (w == c) {
-        return fence_encode_value(x, c);
+        return fence_pattern<FENCE_MAX_BITS>(fence_chunk_value(x, c), c);
     }
     
     // Decompose
-    int block_size = 1 << (w - c);
-    int msc = x / block_size;
-    int tc = x % block_size;
-    bool is_even = (msc % 2 == 0);
+    int tc_shift = w - c;
+    int msc = x >> tc_shift;
+    int tc = x & ((1 << tc_shift) - 1);
     
     // Recursively encode tail
-    string tail_encoded = cgfe_encode_value_internal(tc, w - c, c);
-    
-    // Encode MSC
-    string msc_encoded = fence_encode_value(msc, c);
+    FencePattern tail_encoded = cgfe_encode_value_internal(tc, w - c, c);
     
     // If MSC is odd, flip the first chunk of tail
-    if (!is_even) {
-        int chunk_len = (1 << c) - 1;
-        string first_chunk = tail_encoded.substr(0, chunk_len);
-        
-        auto [start, end] = fence_decode_range(first_chunk, c);
-        int chunk_val = start;
-        int flipped_val = (1 << c) - 1 - chunk_val;
-        
-        string flipped_chunk = fence_encode_value(flipped_val, c);
-        tail_encoded = flipped_chunk + tail_encoded.substr(chunk_len);
+    if (msc & 1) {
+        FenceChunk flipped = fence_chunk_reflect(fence_front(tail_encoded, c), c);
+        tail_encoded = fence_prepend(flipped, c, tail_encoded.drop_front(fence_len(c)));
     }
     
-    return msc_encoded + tail_encoded;
+    // Encode MSC
+    return fence_prepend(fence_chunk_value(msc, c), c, tail_encoded);
 }
 
 // Public interface
 string encode_tc_point(int tc, const CGFEConfig& config) {
-    return cgfe_encode_value_internal(tc, config.tc_bits(), config.c);
+    return cgfe_encode_value_internal(tc, config.tc_bits(), config.c).to_string();
+}
+
+FencePattern cgfe_value_pattern(uint16_t x, const CGFEConfig& config) {
+    return cgfe_encode_value_internal(x, config.W, config.c);
 }
 
 // ===============================================================================
@@ -169,29 +120,24 @@ string encode_tc_point(int tc, const CGFEConfig& config) {
  * prepend_value: Add MSC encoding to each pattern
  * If MSC is odd, flip the first chunk of each pattern
  */
-static vector<string> prepend_value(int p, const vector<string>& E, int c) {
-    vector<string> result;
+template <int c>
+static vector<CGFEWork<c>> prepend_value(int p, const vector<CGFEWork<c>>& E) {
+    constexpr int chunk_len = fence_len(c);
+    vector<CGFEWork<c>> result;
+    result.reserve(E.size());
     
-    string p_encoded = fence_encode_value(p, c);
-    int chunk_len = (1 << c) - 1;
+    FenceChunk p_encoded = fence_chunk_value(p, c);
     bool is_odd = (p % 2 == 1);
     
-    for (const string& e : E) {
-        string new_entry = e;
+    for (const CGFEWork<c>& e : E) {
+        CGFEWork<c> new_entry = e;
         
-        if (is_odd && (int)e.length() >= chunk_len) {
-            string first_chunk = e.substr(0, chunk_len);
-            auto [s, t] = fence_decode_range(first_chunk, c);
-            
-            int max_val = (1 << c) - 1;
-            int flipped_s = max_val - t;
-            int flipped_t = max_val - s;
-            
-            string flipped_chunk = fence_encode_range(flipped_s, flipped_t, c);
-            new_entry = flipped_chunk + e.substr(chunk_len);
+        if (is_odd && e.width >= chunk_len) {
+            FenceChunk flipped = fence_chunk_reflect(fence_front(e, c), c);
+            new_entry = fence_prepend(flipped, c, e.drop_front(chunk_len));
         }
         
-        result.push_back(p_encoded + new_entry);
+        result.push_back(fence_prepend(p_encoded, c, new_entry));
     }
     
     return result;
@@ -200,13 +146,15 @@ static vector<string> prepend_value(int p, const vector<string>& E, int c) {
 /**
  * TC_extract: Remove first chunk from each encoding
  */
-static vector<string> TC_extract(const vector<string>& E, int c) {
-    vector<string> result;
-    int chunk_len = (1 << c) - 1;
-    
-    for (const string& e : E) {
-        if ((int)e.length() > chunk_len) {
-            result.push_back(e.substr(chunk_len));
+template <int c>
+static vector<CGFEWork<c>> TC_extract(const vector<CGFEWork<c>>& E) {
+    constexpr int chunk_len = fence_len(c);
+    vector<CGFEWork<c>> result;
+    result.reserve(E.size());
+    
+    for (const CGFEWork<c>& e : E) {
+        if (e.width > chunk_len) {
+            result.push_back(e.drop_front(chunk_len));
         }
     }
     
@@ -216,31 +164,26 @@ static vector<string> TC_extract(const vector<string>& E, int c) {
 /**
  * reflected_extension: Create reflection-extended encoding
  */
-static vector<string> reflected_extension(int p, int q, const vector<string>& tc_encoding, int c) {
-    vector<string> result;
+template <int c>
+static vector<CGFEWork<c>> reflected_extension(int p, int q, const vector<CGFEWork<c>>& tc_encoding) {
+    vector<CGFEWork<c>> result;
+    result.reserve(tc_encoding.size());
     
-    string range_enc = fence_encode_range(p, q, c);
+    FenceChunk range_enc = fence_chunk_range(p, q, c);
     
-    for (const string& tc : tc_encoding) {
-        result.push_back(range_enc + tc);
+    for (const CGFEWork<c>& tc : tc_encoding) {
+        result.push_back(fence_prepend(range_enc, c, tc));
     }
     
     return result;
 }
 
 /**
- * Generate all-star tail
+ * Fence range of MSCs followed by an all-star tail
  */
-static string generate_star_tail(int w, int c) {
-    int num_chunks = (w - c) / c;
-    int chunk_len = (1 << c) - 1;
-    
-    string result;
-    for (int i = 0; i < num_chunks * chunk_len; i++) {
-        result += '*';
-    }
-    
-    return result;
+template <int c>
+static CGFEWork<c> msc_range_star_tail(int p, int q, int w) {
+    return fence_prepend(fence_chunk_range(p, q, c), c, generate_star_tail<c>(w));
 }
 
 // ===============================================================================
@@ -248,80 +191,258 @@ static string generate_star_tail(int w, int c) {
 // ===============================================================================
 
 // Forward declaration
-static vector<string> CGFE_internal(int start, int end, int w, int c);
+template <int c>
+static vector<CGFEWork<c>> CGFE_internal(int64_t start, int64_t end, int w);
+
+// ===============================================================================
+// Module 5a: Sub-range Memo Cache
+// ===============================================================================
+
+/**
+ * Memo cache for CGFE_internal, keyed on (start, end, w) for one fixed c.
+ *
+ * Rules in an ACL share a small number of tail shapes, so the same
+ * sub-problems (e.g. [ts, max_tc] and [0, te] at w - c) recur across rules.
+ * Every thread has its own tables (one per c), so parallel encoders never
+ * take a lock on the recursion path. Each table is bounded: once it holds
+ * `capacity` entries it is flushed.
+ * Counters are atomics; cgfe_cache_stats() sums them over the live threads
+ * plus the threads that have exited. cgfe_cache_reset() bumps a generation
+ * number, and each thread drops its own tables on its next call.
+ */
+namespace {
+
+struct CGFEMemoKey {
+    uint32_t start;
+    uint32_t end;
+    int w;
+
+    bool operator==(const CGFEMemoKey& o) const {
+        return start == o.start && end == o.end && w == o.w;
+    }
+};
+
+struct CGFEMemoKeyHash {
+    size_t operator()(const CGFEMemoKey& k) const {
+        uint64_t h = ((uint64_t)k.start << 32) ^ (uint64_t)k.end;
+        h ^= (uint64_t)k.w * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        return (size_t)(h * 0xBF58476D1CE4E5B9ULL);
+    }
+};
+
+template <int c>
+using CGFEMemoTable = std::unordered_map<CGFEMemoKey, vector<CGFEWork<c>>, CGFEMemoKeyHash>;
+
+struct CGFEThreadMemo;
+
+// Shared settings and the list of per-thread memos; mutex guards live,
+// retired and the base_* counters of every memo
+struct CGFEMemoRegistry {
+    std::mutex mutex;
+    std::vector<CGFEThreadMemo*> live;
+    CGFECacheStats retired; // Counters of exited threads since the last reset
+    std::atomic<size_t> capacity{CGFE_CACHE_DEFAULT_CAPACITY};
+    std::atomic<uint64_t> generation{0};
+};
+
+CGFEMemoRegistry& cgfe_memo_registry() {
+    static CGFEMemoRegistry registry;
+    return registry;
+}
+
+// Tables are touched only by the owning thread
+struct CGFEThreadMemo {
+    CGFEMemoTable<1> table1;
+    CGFEMemoTable<2> table2;
+    CGFEMemoTable<4> table4;
+    std::atomic<uint64_t> hits{0}, misses{0}, flushes{0};
+    std::atomic<size_t> entries{0};      // Sum of the three table sizes
+    std::atomic<uint64_t> generation{0}; // Registry generation the tables belong to
+    uint64_t base_hits = 0, base_misses = 0, base_flushes = 0; // Counters at the last reset
+
+    CGFEThreadMemo() {
+        CGFEMemoRegistry& reg = cgfe_memo_registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        generation = reg.generation.load();
+        reg.live.push_back(this);
+    }
+
+    ~CGFEThreadMemo() {
+        CGFEMemoRegistry& reg = cgfe_memo_registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired.hits += hits - base_hits;
+        reg.retired.misses += misses - base_misses;
+        reg.retired.flushes += flushes - base_flushes;
+        reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+    }
+
+    template <int c>
+    CGFEMemoTable<c>& table();
+
+    // Drop tables filled before the last cgfe_cache_reset()
+    void sync(uint64_t current) {
+        if (generation.load(std::memory_order_relaxed) == current) return;
+        table1.clear();
+        table2.clear();
+        table4.clear();
+        entries = 0;
+        generation = current;
+    }
+};
+
+template <> CGFEMemoTable<1>& CGFEThreadMemo::table<1>() { return table1; }
+template <> CGFEMemoTable<2>& CGFEThreadMemo::table<2>() { return table2; }
+template <> CGFEMemoTable<4>& CGFEThreadMemo::table<4>() { return table4; }
+
+CGFEThreadMemo& cgfe_thread_memo() {
+    thread_local CGFEThreadMemo memo;
+    return memo;
+}
+
+} // namespace
+
+CGFECacheStats cgfe_cache_stats() {
+    CGFEMemoRegistry& reg = cgfe_memo_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    CGFECacheStats s = reg.retired;
+    uint64_t current = reg.generation.load();
+    for (const CGFEThreadMemo* m : reg.live) {
+        s.hits += m->hits - m->base_hits;
+        s.misses += m->misses - m->base_misses;
+        s.flushes += m->flushes - m->base_flushes;
+        if (m->generation.load() == current) s.entries += m->entries;
+    }
+    s.capacity = reg.capacity;
+    return s;
+}
+
+void cgfe_cache_reset(size_t capacity) {
+    CGFEMemoRegistry& reg = cgfe_memo_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (CGFEThreadMemo* m : reg.live) {
+        m->base_hits = m->hits;
+        m->base_misses = m->misses;
+        m->base_flushes = m->flushes;
+    }
+    reg.retired = CGFECacheStats();
+    reg.capacity = capacity;
+    reg.generation++;
+}
+
+template <int c>
+static vector<CGFEWork<c>> CGFE_compute(int64_t start, int64_t end, int w);
+
+/**
+ * Cached front end of the CGFE recursion (lock-free: per-thread tables)
+ */
+template <int c>
+static vector<CGFEWork<c>> CGFE_internal(int64_t start, int64_t end, int w) {
+    if (start > end) return {};
+
+    CGFEMemoRegistry& reg = cgfe_memo_registry();
+    size_t capacity = reg.capacity.load(std::memory_order_relaxed);
+    if (capacity == 0) return CGFE_compute<c>(start, end, w);
+
+    CGFEThreadMemo& memo = cgfe_thread_memo();
+    memo.sync(reg.generation.load(std::memory_order_relaxed));
+    CGFEMemoTable<c>& table = memo.table<c>();
+    CGFEMemoKey key{(uint32_t)start, (uint32_t)end, w};
+    auto it = table.find(key);
+    if (it != table.end()) {
+        memo.hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+    memo.misses.fetch_add(1, std::memory_order_relaxed);
+
+    vector<CGFEWork<c>> result = CGFE_compute<c>(start, end, w);
+
+    if (table.size() >= capacity) {
+        memo.entries -= table.size();
+        table.clear();
+        memo.flushes.fetch_add(1, std::memory_order_relaxed);
+    }
+    table.emplace(key, result);
+    memo.entries.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
 
 /**
  * CGFE_PARTIAL: Encode with k values already covered
  */
-static vector<string> CGFE_PARTIAL(int start, int end, int k, int w, int c) {
-    int size = end - start + 1;
+template <int c>
+static vector<CGFEWork<c>> CGFE_PARTIAL(int64_t start, int64_t end, int64_t k, int w) {
+    int64_t size = end - start + 1;
     
     if (k >= size) return {};
-    if (k == 0) return CGFE_internal(start, end, w, c);
+    if (k == 0) return CGFE_internal<c>(start, end, w);
     
-    return CGFE_internal(start + k, end, w, c);
+    return CGFE_internal<c>(start + k, end, w);
+}
+
+template <class T>
+static void append_all(vector<T>& dst, const vector<T>& src) {
+    dst.insert(dst.end(), src.begin(), src.end());
 }
 
 /**
- * Main CGFE algorithm
+ * Main CGFE algorithm (uncached body, sub-problems go through CGFE_internal)
+ *
+ * c is a template parameter, so block size, MSC and TC are shifts and masks
+ * by (w - c); w only changes by c per recursion level.
  */
-static vector<string> CGFE_internal(int start, int end, int w, int c) {
+template <int c>
+static vector<CGFEWork<c>> CGFE_compute(int64_t start, int64_t end, int w) {
+    using Work = CGFEWork<c>;
     if (start > end) return {};
     
-    int block_size = 1 << (w - c);
-    int max_tc = block_size - 1;
+    const int tc_shift = w - c;
+    const int64_t block_size = (int64_t)1 << tc_shift;
+    const int64_t max_tc = block_size - 1;
     
     // Decompose
-    int ms = start / block_size;
-    int me = end / block_size;
-    int ts = start % block_size;
-    int te = end % block_size;
+    int ms = (int)(start >> tc_shift);
+    int me = (int)(end >> tc_shift);
+    int64_t ts = start & max_tc;
+    int64_t te = end & max_tc;
     
     // Case 1: Local range (same block)
     if (ms == me) {
         if (w == c) {
-            return { fence_encode_range(start, end, c) };
+            return { fence_pattern<Work::capacity>(fence_chunk_range((int)start, (int)end, c), c) };
         }
-        vector<string> E = CGFE_internal(ts, te, w - c, c);
-        return prepend_value(ms, E, c);
+        vector<Work> E = CGFE_internal<c>(ts, te, w - c);
+        return prepend_value<c>(ms, E);
     }
     
     // Case 2: Middle range (ts == 0 and te == max_tc)
     if (ts == 0 && te == max_tc) {
-        string range_enc = fence_encode_range(ms, me, c);
-        string star_tail = generate_star_tail(w, c);
-        return { range_enc + star_tail };
+        return { msc_range_star_tail<c>(ms, me, w) };
     }
     
     // Case 3: Bottom range (ts == 0)
     if (ts == 0 && te != max_tc) {
-        vector<string> result;
+        vector<Work> result;
         
         if (ms <= me - 1) {
-            string range_enc = fence_encode_range(ms, me - 1, c);
-            string star_tail = generate_star_tail(w, c);
-            result.push_back(range_enc + star_tail);
+            result.push_back(msc_range_star_tail<c>(ms, me - 1, w));
         }
         
-        vector<string> E2 = CGFE_internal(0, te, w - c, c);
-        vector<string> E2_with_msc = prepend_value(me, E2, c);
-        result.insert(result.end(), E2_with_msc.begin(), E2_with_msc.end());
+        vector<Work> E2 = CGFE_internal<c>(0, te, w - c);
+        append_all(result, prepend_value<c>(me, E2));
         
         return result;
     }
     
     // Case 4: Top range (te == max_tc)
     if (te == max_tc && ts != 0) {
-        vector<string> result;
+        vector<Work> result;
         
-        vector<string> E1 = CGFE_internal(ts, max_tc, w - c, c);
-        vector<string> E1_with_msc = prepend_value(ms, E1, c);
-        result.insert(result.end(), E1_with_msc.begin(), E1_with_msc.end());
+        vector<Work> E1 = CGFE_internal<c>(ts, max_tc, w - c);
+        append_all(result, prepend_value<c>(ms, E1));
         
         if (ms + 1 <= me) {
-            string range_enc = fence_encode_range(ms + 1, me, c);
-            string star_tail = generate_star_tail(w, c);
-            result.push_back(range_enc + star_tail);
+            result.push_back(msc_range_star_tail<c>(ms + 1, me, w));
         }
         
         return result;
@@ -329,73 +450,59 @@ static vector<string> CGFE_internal(int start, int end, int w, int c) {
     
     // Case 5: Regular range
     {
-        vector<string> result;
+        vector<Work> result;
         
-        int r1_end = (ms + 1) * block_size - 1;
-        int r3_start = me * block_size;
+        int64_t r1_end = ((int64_t)(ms + 1) << tc_shift) - 1;
+        int64_t r3_start = (int64_t)me << tc_shift;
         
-        int r1_size = r1_end - start + 1;
-        int r3_size = end - r3_start + 1;
+        int64_t r1_size = r1_end - start + 1;
+        int64_t r3_size = end - r3_start + 1;
         
         int delta = me - ms;
         
         if (delta % 2 == 1) {
             // Odd delta
             if (r1_size <= r3_size) {
-                vector<string> E1 = CGFE_internal(ts, max_tc, w - c, c);
-                vector<string> TC_E1 = TC_extract(prepend_value(ms, E1, c), c);
+                vector<Work> E1 = CGFE_internal<c>(ts, max_tc, w - c);
+                vector<Work> TC_E1 = TC_extract<c>(prepend_value<c>(ms, E1));
                 
-                vector<string> E1_ext = reflected_extension(ms, me, TC_E1, c);
-                result.insert(result.end(), E1_ext.begin(), E1_ext.end());
+                append_all(result, reflected_extension<c>(ms, me, TC_E1));
                 
-                vector<string> E3 = CGFE_PARTIAL(0, te, r1_size, w - c, c);
-                vector<string> E3_with_msc = prepend_value(me, E3, c);
-                result.insert(result.end(), E3_with_msc.begin(), E3_with_msc.end());
+                vector<Work> E3 = CGFE_PARTIAL<c>(0, te, r1_size, w - c);
+                append_all(result, prepend_value<c>(me, E3));
             } else {
-                vector<string> E3 = CGFE_internal(0, te, w - c, c);
-                vector<string> TC_E3 = TC_extract(prepend_value(me, E3, c), c);
+                vector<Work> E3 = CGFE_internal<c>(0, te, w - c);
+                vector<Work> TC_E3 = TC_extract<c>(prepend_value<c>(me, E3));
                 
-                vector<string> E3_ext = reflected_extension(ms, me, TC_E3, c);
-                result.insert(result.end(), E3_ext.begin(), E3_ext.end());
+                append_all(result, reflected_extension<c>(ms, me, TC_E3));
                 
-                int r1_partial_end = max_tc - r3_size;
+                int64_t r1_partial_end = max_tc - r3_size;
                 if (ts <= r1_partial_end) {
-                    vector<string> E1 = CGFE_internal(ts, r1_partial_end, w - c, c);
-                    vector<string> E1_with_msc = prepend_value(ms, E1, c);
-                    result.insert(result.end(), E1_with_msc.begin(), E1_with_msc.end());
+                    vector<Work> E1 = CGFE_internal<c>(ts, r1_partial_end, w - c);
+                    append_all(result, prepend_value<c>(ms, E1));
                 }
             }
             
             if (ms + 1 <= me - 1) {
-                string range_enc = fence_encode_range(ms + 1, me - 1, c);
-                string star_tail = generate_star_tail(w, c);
-                result.push_back(range_enc + star_tail);
+                result.push_back(msc_range_star_tail<c>(ms + 1, me - 1, w));
             }
         } else {
             // Even delta
-            vector<string> E1 = CGFE_internal(ts, max_tc, w - c, c);
-            vector<string> TC_E1 = TC_extract(prepend_value(ms, E1, c), c);
+            vector<Work> E1 = CGFE_internal<c>(ts, max_tc, w - c);
+            vector<Work> TC_E1 = TC_extract<c>(prepend_value<c>(ms, E1));
             
-            vector<string> E3 = CGFE_internal(0, te, w - c, c);
-            vector<string> TC_E3 = TC_extract(prepend_value(me, E3, c), c);
+            vector<Work> E3 = CGFE_internal<c>(0, te, w - c);
+            vector<Work> TC_E3 = TC_extract<c>(prepend_value<c>(me, E3));
             
             if (r1_size + r3_size >= block_size) {
-                vector<string> E1_ext = reflected_extension(ms, me - 1, TC_E1, c);
-                result.insert(result.end(), E1_ext.begin(), E1_ext.end());
-                
-                vector<string> E3_ext = reflected_extension(ms + 1, me, TC_E3, c);
-                result.insert(result.end(), E3_ext.begin(), E3_ext.end());
+                append_all(result, reflected_extension<c>(ms, me - 1, TC_E1));
+                append_all(result, reflected_extension<c>(ms + 1, me, TC_E3));
             } else {
-                vector<string> E1_with_msc = prepend_value(ms, E1, c);
-                result.insert(result.end(), E1_with_msc.begin(), E1_with_msc.end());
-                
-                vector<string> E3_with_msc = prepend_value(me, E3, c);
-                result.insert(result.end(), E3_with_msc.begin(), E3_with_msc.end());
+                append_all(result, prepend_value<c>(ms, E1));
+                append_all(result, prepend_value<c>(me, E3));
                 
                 if (ms + 1 <= me - 1) {
-                    string range_enc = fence_encode_range(ms + 1, me - 1, c);
-                    string star_tail = generate_star_tail(w, c);
-                    result.push_back(range_enc + star_tail);
+                    result.push_back(msc_range_star_tail<c>(ms + 1, me - 1, w));
                 }
             }
         }
@@ -404,12 +511,27 @@ static vector<string> CGFE_internal(int start, int end, int w, int c) {
     }
 }
 
+/**
+ * Runtime-c entry into the templated recursion (text form)
+ */
+static vector<string> CGFE_internal_text(int64_t start, int64_t end, int w, int c) {
+    vector<string> out;
+    switch (c) {
+    case 1: for (const auto& p : CGFE_internal<1>(start, end, w)) out.push_back(p.to_string()); break;
+    case 2: for (const auto& p : CGFE_internal<2>(start, end, w)) out.push_back(p.to_string()); break;
+    case 4: for (const auto& p : CGFE_internal<4>(start, end, w)) out.push_back(p.to_string()); break;
+    default:
+        throw std::invalid_argument("CGFE: unsupported chunk parameter c=" + to_string(c));
+    }
+    return out;
+}
+
 // ===============================================================================
 // Module 6: Public Interface - CGFEResult generation
 // ===============================================================================
 
 string encode_msc_range(int msc_lo, int msc_hi, const CGFEConfig& config) {
-    return fence_encode_range(msc_lo, msc_hi, config.c);
+    return fence_pattern<FENCE_MAX_BITS>(fence_chunk_range(msc_lo, msc_hi, config.c), config.c).to_string();
 }
 
 vector<string> encode_tc_range(int tc_lo, int tc_hi, 
@@ -417,26 +539,43 @@ vector<string> encode_tc_range(int tc_lo, int tc_hi,
                                 int skip_prefix_len,
                                 bool msc_parity) {
     // Use the new internal CGFE algorithm
-    return CGFE_internal(tc_lo, tc_hi, config.tc_bits(), config.c);
+    return CGFE_internal_text(tc_lo, tc_hi, config.tc_bits(), config.c);
 }
 
-CGFEResult cgfe_encode_range(uint16_t s, uint16_t e, 
-                              const CGFEConfig& config,
-                              int skip_prefix_len) {
-    CGFEResult result;
+template <int W_, int C_>
+std::vector<typename CGFEEncoder<W_, C_>::pattern_type>
+CGFEEncoder<W_, C_>::encode_range(value_type s, value_type e) {
+    std::vector<pattern_type> patterns;
     
-    if (s > e) return result;
+    if (s > e) return patterns;
     
-    // Use the new algorithm
-    vector<string> patterns = CGFE_internal(s, e, config.W, config.c);
+    for (const auto& pat : CGFE_internal<C_>(s, e, W_)) {
+        patterns.push_back(pattern_type::from(pat));
+    }
     
-    for (const string& pat : patterns) {
+    return patterns;
+}
+
+template struct CGFEEncoder<16, 1>;
+template struct CGFEEncoder<16, 2>;
+template struct CGFEEncoder<16, 4>;
+template struct CGFEEncoder<32, 2>;
+template struct CGFEEncoder<32, 4>;
+
+/**
+ * Wrap packed patterns of a 16-bit encoder into CGFEEntry records
+ */
+template <class Encoder>
+static CGFEResult cgfe_port_result(uint16_t s, uint16_t e) {
+    CGFEResult result;
+    
+    for (const auto& pat : Encoder::encode_range(s, e)) {
         CGFEEntry entry;
         // For the new algorithm, MSC is encoded in the pattern
         // We set msc_lo/hi to 0 and store the full pattern in tc_pattern
         entry.msc_lo = 0;
         entry.msc_hi = 0;
-        entry.tc_pattern = pat;  // Full pattern including MSC
+        entry.tc_pattern = FencePattern::from(pat);  // Full pattern including MSC
         entry.orig_lo = s;
         entry.orig_hi = e;
         result.entries.push_back(entry);
@@ -445,6 +584,24 @@ CGFEResult cgfe_encode_range(uint16_t s, uint16_t e,
     return result;
 }
 
+CGFEResult cgfe_encode_range(uint16_t s, uint16_t e, 
+                              const CGFEConfig& config,
+                              int skip_prefix_len) {
+    if (s > e) return CGFEResult();
+    
+    if (config.W == 16) {
+        switch (config.c) {
+        case 1: return cgfe_port_result<CGFEEncoder<16, 1>>(s, e);
+        case 2: return cgfe_port_result<CGFEEncoder<16, 2>>(s, e);
+        case 4: return cgfe_port_result<CGFEEncoder<16, 4>>(s, e);
+        default: break;
+        }
+    }
+    
+    throw std::invalid_argument("CGFE: unsupported configuration W=" + to_string(config.W) +
+                                ", c=" + to_string(config.c));
+}
+
 // ===============================================================================
 // Module 7: Utility Functions
 // ===============================================================================
@@ -462,8 +619,8 @@ void print_cgfe_result(const CGFEResult& result, const string& label) {
     }
 }
 
-vector<string> cgfe_to_ternary(const CGFEResult& result, const CGFEConfig& config) {
-    vector<string> ternary_list;
+vector<FencePattern> cgfe_to_ternary(const CGFEResult& result, const CGFEConfig& config) {
+    vector<FencePattern> ternary_list;
     
     for (const auto& entry : result.entries) {
         // The pattern already includes MSC encoding
@@ -477,27 +634,62 @@ vector<string> cgfe_to_ternary(const CGFEResult& result, const CGFEConfig& confi
 // Module 8: Port Processing Implementation
 // ===============================================================================
 
-std::vector<CGFEPort> CGFE_encode_ports(const std::vector<PortRule>& port_table, 
-                                        const CGFEConfig& config) {
-    std::vector<CGFEPort> result;
-    
-    for (const auto& port_rule : port_table) {
-        CGFEPort cport;
-        cport.src_port_lo = port_rule.src_port_lo;
-        cport.src_port_hi = port_rule.src_port_hi;
-        cport.dst_port_lo = port_rule.dst_port_lo;
-        cport.dst_port_hi = port_rule.dst_port_hi;
-        cport.priority = port_rule.priority;
-        cport.action = port_rule.action;
+// Whole-range results shared across rules; the key carries (W, c)
+static RangeInternTable<CGFEResult> g_cgfe_intern;
+
+static CGFEHandle cgfe_intern(uint16_t lo, uint16_t hi, const CGFEConfig& config) {
+    uint32_t params = ((uint32_t)config.W << 8) | (uint32_t)config.c;
+    return g_cgfe_intern.intern(params, lo, hi, [&config](uint16_t s, uint16_t e) {
+        return cgfe_encode_range(s, e, config);
+    });
+}
+
+RangeInternStats cgfe_intern_stats() {
+    return g_cgfe_intern.stats();
+}
+
+void cgfe_intern_clear() {
+    g_cgfe_intern.clear();
+}
+
+std::vector<CGFEPort> CGFE_encode_ports(const PortTable& port_table, 
+                                        const CGFEConfig& config, int threads) {
+    ThreadPool pool(threads);
+    return CGFE_encode_ports(port_table, config, pool);
+}
+
+std::vector<CGFEPort> CGFE_encode_ports(const PortTable& port_table, 
+                                        const CGFEConfig& config, ThreadPool& pool) {
+    // Pre-sized so parallel workers fill slots by index (input order preserved)
+    std::vector<CGFEPort> result(port_table.size());
+    if (port_table.empty()) {
+        return result;
+    }
+    
+    // Port columns of the RuleTable, read in place
+    const uint16_t* src_lo = port_table.src_port_lo();
+    const uint16_t* src_hi = port_table.src_port_hi();
+    const uint16_t* dst_lo = port_table.dst_port_lo();
+    const uint16_t* dst_hi = port_table.dst_port_hi();
+    const uint32_t* priority = port_table.priority();
+    const uint16_t* action_id = port_table.action_id();
+    
+    parallel_for_each_index(port_table.size(), pool, [&](size_t i) {
+        CGFEPort& cport = result[i];
+        cport.src_port_lo = src_lo[i];
+        cport.src_port_hi = src_hi[i];
+        cport.dst_port_lo = dst_lo[i];
+        cport.dst_port_hi = dst_hi[i];
+        cport.priority = priority[i];
+        cport.rid = port_table.rid(i);
+        cport.action_id = action_id[i];
         
         // Encode source port range
-        cport.src_cgfe = cgfe_encode_range(port_rule.src_port_lo, port_rule.src_port_hi, config);
+        cport.src_cgfe = cgfe_intern(src_lo[i], src_hi[i], config);
         
         // Encode destination port range
-        cport.dst_cgfe = cgfe_encode_range(port_rule.dst_port_lo, port_rule.dst_port_hi, config);
-        
-        result.push_back(cport);
-    }
+        cport.dst_cgfe = cgfe_intern(dst_lo[i], dst_hi[i], config);
+    });
     
     return result;
 }
@@ -505,20 +697,16 @@ std::vector<CGFEPort> CGFE_encode_ports(const std::vector<PortRule>& port_table,
 std::vector<CGFETCAM_Entry> generate_cgfe_tcam_entries(const std::vector<CGFEPort>& cgfe_ports) {
     std::vector<CGFETCAM_Entry> tcam_entries;
     
-    // For W=16, c=2: each chunk encodes to 3 bits, 8 chunks total = 24 bits
-    CGFEConfig config16 = {16, 2};
-    
+    // Patterns already carry their full width (derived from the encoder's W and c)
     for (const auto& cport : cgfe_ports) {
-        auto src_patterns = cgfe_to_ternary(cport.src_cgfe, config16);
-        auto dst_patterns = cgfe_to_ternary(cport.dst_cgfe, config16);
-        
-        for (const auto& src_pat : src_patterns) {
-            for (const auto& dst_pat : dst_patterns) {
+        for (const auto& src_entry : cport.src_cgfe->entries) {
+            for (const auto& dst_entry : cport.dst_cgfe->entries) {
                 CGFETCAM_Entry entry;
-                entry.src_pattern = src_pat;
-                entry.dst_pattern = dst_pat;
+                entry.src_pattern = src_entry.tc_pattern;
+                entry.dst_pattern = dst_entry.tc_pattern;
                 entry.priority = cport.priority;
-                entry.action = cport.action;
+                entry.rid = cport.rid;
+                entry.action_id = cport.action_id;
                 tcam_entries.push_back(entry);
             }
         }
@@ -527,65 +715,100 @@ std::vector<CGFETCAM_Entry> generate_cgfe_tcam_entries(const std::vector<CGFEPor
     return tcam_entries;
 }
 
-void print_cgfe_tcam_rules(const std::vector<CGFETCAM_Entry>& tcam_entries,
-                           const std::vector<IPRule>& ip_table,
-                           const std::string& output_file) {
-    std::ostream* out = &std::cout;
-    std::ofstream outf;
-    
-    if (!output_file.empty()) {
-        outf.open(output_file);
-        if (!outf.is_open()) {
-            std::cerr << "[ERROR] Cannot open output file: " << output_file << std::endl;
-            return;
-        }
-        out = &outf;
+bool CGFETcamStream::open(const std::string& output_file, const CGFEConfig& config) {
+    total_ = 0;
+    pattern_bits_ = config.output_bits();
+    if (!out_.open(output_file)) {
+        return false;
     }
     
-    *out << "# CGFE (Chunked Gray Fence Encoding) TCAM Rules\n";
-    *out << "# Format: SRC_IP DST_IP SRC_PORT DST_PORT PROTOCOL ACTION\n";
-    *out << "# Port patterns: 24 bits (8 chunks × 3 bits per chunk for W=16, c=2)\n";
-    *out << "#\n";
+    out_.put_literal("# CGFE (Chunked Gray Fence Encoding) TCAM Rules\n");
+    out_.put_literal("# Format: SRC_IP DST_IP SRC_PORT DST_PORT PROTOCOL ACTION\n");
+    out_.put_literal("# Port patterns: ");
+    out_.put_uint(pattern_bits_);
+    out_.put_literal(" bits (");
+    out_.put_uint(config.num_chunks());
+    out_.put_literal(" chunks × ");
+    out_.put_uint(config.fence_bits());
+    out_.put_literal(" bits per chunk for W=");
+    out_.put_uint(config.W);
+    out_.put_literal(", c=");
+    out_.put_uint(config.c);
+    out_.put_literal(")\n#\n");
+    return true;
+}
+
+void CGFETcamStream::write(const std::vector<CGFETCAM_Entry>& tcam_entries, const IPTable& ip_table,
+                           std::vector<RuleOutputSize>* per_rule) {
+    if (!out_.is_open()) {
+        return;
+    }
     
-    int entry_count = 0;
-    for (const auto& ip_rule : ip_table) {
-        for (const auto& port_entry : tcam_entries) {
-            if (port_entry.priority != ip_rule.priority) {
-                continue;
-            }
-            
-            auto ip_to_string = [](uint32_t ip) -> std::string {
-                return std::to_string((ip >> 24) & 0xFF) + "." +
-                       std::to_string((ip >> 16) & 0xFF) + "." +
-                       std::to_string((ip >> 8) & 0xFF) + "." +
-                       std::to_string(ip & 0xFF);
-            };
-            
-            std::string src_ip = ip_to_string(ip_rule.src_ip_lo);
-            std::string dst_ip = ip_to_string(ip_rule.dst_ip_lo);
-            
-            // Pad patterns to 24 bits if needed
-            std::string src_pat = port_entry.src_pattern;
-            std::string dst_pat = port_entry.dst_pattern;
-            while (src_pat.length() < 24) src_pat = "0" + src_pat;
-            while (dst_pat.length() < 24) dst_pat = "0" + dst_pat;
-            
-            *out << src_ip << " " 
-                 << dst_ip << " "
-                 << src_pat << " "
-                 << dst_pat << " "
-                 << "0x" << std::hex << std::setfill('0') << std::setw(2) << (int)ip_rule.proto << std::dec << " "
-                 << port_entry.action << "\n";
-            
-            entry_count++;
+    // Entries are generated in port_table order, which is rule order, so a
+    // single pass over the entries keeps the rule-major output order
+    IPRuleIndex ip_index(ip_table);
+    for (const auto& port_entry : tcam_entries) {
+        IPRule ip_rule;
+        if (!ip_index.find(port_entry.rid, port_entry.priority, ip_rule)) {
+            continue;
+        }
+        
+        uint64_t start = out_.offset();
+        out_.put_ipv4(ip_rule.src_ip_lo);
+        out_.put(' ');
+        out_.put_ipv4(ip_rule.dst_ip_lo);
+        out_.put(' ');
+        
+        // Patterns padded to the configured output width if needed
+        out_.put_pattern(port_entry.src_pattern, pattern_bits_);
+        out_.put(' ');
+        out_.put_pattern(port_entry.dst_pattern, pattern_bits_);
+        
+        out_.put_literal(" 0x");
+        out_.put_hex2(ip_rule.proto);
+        out_.put(' ');
+        out_.put(ip_table.action(port_entry.action_id));
+        out_.put('\n');
+        
+        total_++;
+        if (per_rule) {
+            RuleOutputSize& size = (*per_rule)[port_entry.rid];
+            size.bytes += (uint32_t)(out_.offset() - start);
+            size.entries++;
         }
     }
+}
+
+void CGFETcamStream::write_raw(const char* data, size_t n, uint64_t entries) {
+    if (!out_.is_open()) {
+        return;
+    }
+    out_.put(data, n);
+    total_ += entries;
+}
+
+TcamWriteStats CGFETcamStream::close() {
+    if (!out_.is_open()) {
+        return TcamWriteStats();
+    }
     
-    *out << "\n# Total TCAM entries: " << entry_count << "\n";
+    out_.put_literal("\n# Total TCAM entries: ");
+    out_.put_uint(total_);
+    out_.put('\n');
     
-    if (outf.is_open()) {
-        outf.close();
+    return out_.close();
+}
+
+TcamWriteStats print_cgfe_tcam_rules(const std::vector<CGFETCAM_Entry>& tcam_entries,
+                                     const IPTable& ip_table,
+                                     const CGFEConfig& config,
+                                     const std::string& output_file) {
+    CGFETcamStream stream;
+    if (!stream.open(output_file, config)) {
+        return TcamWriteStats();
     }
+    stream.write(tcam_entries, ip_table);
+    return stream.close();
 }
 
 
@@ -12,7 +12,12 @@
 #include <string>
 #include <cstdint>
 #include <utility>
+#include <type_traits>
 #include "Loader.hpp"
+#include "Ternary.hpp"
+#include "Parallel.hpp"
+#include "RangeIntern.hpp"
+#include "TcamWriter.hpp"
 
 // ===============================================================================
 // CGFE Configuration
@@ -24,10 +29,13 @@ struct CGFEConfig
     int c; // Chunk parameter (bits per chunk)
 
     // Derived parameters
-    int block_size() const { return 1 << (W - c); } // 2^(W-c)
-    int num_blocks() const { return 1 << c; }       // 2^c
-    int tc_bits() const { return W - c; }           // Bits for TC
-    int msc_bits() const { return c; }              // Bits for MSC
+    constexpr int block_size() const { return 1 << (W - c); } // 2^(W-c)
+    constexpr int num_blocks() const { return 1 << c; }       // 2^c
+    constexpr int tc_bits() const { return W - c; }           // Bits for TC
+    constexpr int msc_bits() const { return c; }              // Bits for MSC
+    constexpr int num_chunks() const { return W / c; }        // Chunks per value
+    constexpr int fence_bits() const { return (1 << c) - 1; } // Encoded bits per chunk
+    constexpr int output_bits() const { return num_chunks() * fence_bits(); }
 };
 
 // ===============================================================================
@@ -38,7 +46,7 @@ struct CGFEEntry
 {
     int msc_lo;             // MSC range low
     int msc_hi;             // MSC range high
-    std::string tc_pattern; // TC ternary pattern (with *)
+    FencePattern tc_pattern; // TC ternary pattern (packed value/mask)
 
     // For debugging
     uint16_t orig_lo; // Original range low
@@ -57,6 +65,41 @@ struct CGFEResult
     int total_entries() const { return entries.size(); }
 };
 
+// ===============================================================================
+// Compile-time Specialized Encoder
+// ===============================================================================
+
+// CGFEEncoder<W, c>: only c specializes the encoding (CGFE_internal<c>, fence
+// tables of 2^c - 1 bits); W is passed on at run time and just selects the
+// value and pattern types. Explicitly instantiated in CGFE_code.cpp for
+// (16,1), (16,2), (16,4), (32,2) and (32,4).
+template <int W_, int C_>
+struct CGFEEncoder
+{
+    static_assert(C_ == 1 || C_ == 2 || C_ == 4, "CGFE chunk parameter c must be 1, 2 or 4");
+    static_assert(W_ % C_ == 0 && W_ <= 32, "W must be a multiple of c and at most 32");
+
+    static constexpr int W = W_;
+    static constexpr int c = C_;
+    static constexpr int num_chunks = W / c;
+    static constexpr int fence_bits = (1 << c) - 1;             // Encoded bits per chunk
+    static constexpr int output_bits = num_chunks * fence_bits; // Full pattern width
+
+    using value_type = typename std::conditional<(W <= 16), uint16_t, uint32_t>::type;
+    using pattern_type = Ternary<output_bits>;
+
+    static constexpr CGFEConfig config() { return CGFEConfig{W, c}; }
+
+    // Encode [s, e] into packed patterns of output_bits symbols
+    static std::vector<pattern_type> encode_range(value_type s, value_type e);
+};
+
+extern template struct CGFEEncoder<16, 1>;
+extern template struct CGFEEncoder<16, 2>;
+extern template struct CGFEEncoder<16, 4>;
+extern template struct CGFEEncoder<32, 2>;
+extern template struct CGFEEncoder<32, 4>;
+
 // ===============================================================================
 // Module 1: Basic Math Functions
 // ===============================================================================
@@ -81,6 +124,9 @@ uint16_t block_end(int msc, const CGFEConfig &config);
 // Uses Gray-code chunk encoding with parity propagation
 std::string encode_tc_point(int tc, const CGFEConfig &config);
 
+// Encode a full W-bit value (every symbol is a care bit): the lookup key of x
+FencePattern cgfe_value_pattern(uint16_t x, const CGFEConfig &config);
+
 // ===============================================================================
 // Module 3: TC Range Encoding
 // ===============================================================================
@@ -114,10 +160,39 @@ std::string encode_msc_range(int msc_lo, int msc_hi, const CGFEConfig &config);
 
 // Main entry: Encode range [s, e] using CGFE algorithm
 // skip_prefix_len: for partial encoding (bits already covered)
+// Dispatches to CGFEEncoder<16, c>; throws std::invalid_argument for other configs
 CGFEResult cgfe_encode_range(uint16_t s, uint16_t e,
                              const CGFEConfig &config,
                              int skip_prefix_len = 0);
 
+// ===============================================================================
+// Module 6a: Sub-range Memo Cache
+// ===============================================================================
+
+constexpr size_t CGFE_CACHE_DEFAULT_CAPACITY = 1 << 16;
+
+struct CGFECacheStats
+{
+    uint64_t hits = 0;    // CGFE_internal calls served from the cache
+    uint64_t misses = 0;  // CGFE_internal calls that had to recurse
+    uint64_t flushes = 0; // Times the cache hit capacity and was cleared
+    size_t entries = 0;   // Current number of cached sub-ranges
+    size_t capacity = 0;  // Maximum cached sub-ranges per thread and c
+
+    double hit_rate() const
+    {
+        uint64_t total = hits + misses;
+        return total ? (double)hits / total : 0.0;
+    }
+};
+
+// Counters of the (start, end, w) memo cache used by cgfe_encode_range,
+// summed over all encoder threads (every thread caches on its own)
+CGFECacheStats cgfe_cache_stats();
+
+// Drop all cached sub-ranges and counters; capacity 0 disables the cache
+void cgfe_cache_reset(size_t capacity = CGFE_CACHE_DEFAULT_CAPACITY);
+
 // ===============================================================================
 // Module 7: Utility Functions
 // ===============================================================================
@@ -125,43 +200,76 @@ CGFEResult cgfe_encode_range(uint16_t s, uint16_t e,
 // Print CGFE result for debugging
 void print_cgfe_result(const CGFEResult &result, const std::string &label = "");
 
-// Convert CGFE entries to full ternary strings
-std::vector<std::string> cgfe_to_ternary(const CGFEResult &result, const CGFEConfig &config);
+// Collect the full ternary patterns of a CGFE result
+std::vector<FencePattern> cgfe_to_ternary(const CGFEResult &result, const CGFEConfig &config);
 
 // ===============================================================================
 // Port Processing Structures
 // ===============================================================================
 
-// Forward declaration
-struct PortRule;
-struct IPRule;
+// Interned CGFE result: every rule with the same port range shares one encoding
+using CGFEHandle = RangeInternTable<CGFEResult>::Handle;
 
 struct CGFEPort
 {
     uint16_t src_port_lo, src_port_hi;
     uint16_t dst_port_lo, dst_port_hi;
     uint32_t priority;
-    std::string action;
-    CGFEResult src_cgfe;
-    CGFEResult dst_cgfe;
+    uint32_t rid = UINT32_MAX; // RuleTable row (PortRule::rid)
+    uint16_t action_id = 0;    // RuleTable::actions index
+    CGFEHandle src_cgfe;
+    CGFEHandle dst_cgfe;
 };
 
 struct CGFETCAM_Entry
 {
-    std::string src_pattern;
-    std::string dst_pattern;
+    FencePattern src_pattern;
+    FencePattern dst_pattern;
     uint32_t priority;
-    std::string action;
+    uint32_t rid = UINT32_MAX; // RuleTable row, used by the writer's join
+    uint16_t action_id = 0;    // Text is looked up by the writer
 };
 
 // Encode all port rules using CGFE
-std::vector<CGFEPort> CGFE_encode_ports(const std::vector<PortRule> &port_table,
-                                        const CGFEConfig &config);
+// threads: 1 = serial, 0 = all hardware threads; output order is the same either way
+std::vector<CGFEPort> CGFE_encode_ports(const PortTable &port_table,
+                                        const CGFEConfig &config, int threads = 1);
+
+// Same, on the threads of a pool kept by the caller (e.g. across streaming batches)
+std::vector<CGFEPort> CGFE_encode_ports(const PortTable &port_table,
+                                        const CGFEConfig &config, ThreadPool &pool);
+
+// Distinct ranges and hit rate of the CGFE range intern table
+RangeInternStats cgfe_intern_stats();
+
+// Drop all interned ranges and reset the stats (e.g. between streaming batches)
+void cgfe_intern_clear();
 
 // Generate TCAM entries from CGFE encoded ports
 std::vector<CGFETCAM_Entry> generate_cgfe_tcam_entries(const std::vector<CGFEPort> &cgfe_ports);
 
-// Print TCAM rules
-void print_cgfe_tcam_rules(const std::vector<CGFETCAM_Entry> &tcam_entries,
-                           const std::vector<IPRule> &ip_table,
-                           const std::string &output_file = "");
+// Streaming form of print_cgfe_tcam_rules: the same file, written batch by batch
+class CGFETcamStream
+{
+public:
+    // Header; false if the file cannot be created
+    bool open(const std::string &output_file, const CGFEConfig &config);
+    void write(const std::vector<CGFETCAM_Entry> &tcam_entries, const IPTable &ip_table,
+               std::vector<RuleOutputSize> *per_rule = nullptr);
+    void write_raw(const char *data, size_t n, uint64_t entries);
+    TcamWriteStats close(); // footer with the number of entries written
+
+    uint64_t offset() const { return out_.offset(); }
+
+private:
+    TcamWriter out_;
+    int pattern_bits_ = 0;
+    uint64_t total_ = 0;
+};
+
+// Print TCAM rules (pattern width taken from config.output_bits());
+// returns bytes written and throughput
+TcamWriteStats print_cgfe_tcam_rules(const std::vector<CGFETCAM_Entry> &tcam_entries,
+                                     const IPTable &ip_table,
+                                     const CGFEConfig &config,
+                                     const std::string &output_file = "");
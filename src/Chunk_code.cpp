@@ -12,11 +12,12 @@
 #include <cstdint>
 #include <cassert>
 #include <algorithm>
-#include <iomanip>
-#include <fstream>
 
 #include "Chunk_code.hpp"
+#include "Fence.hpp"
 #include "Loader.hpp"
+#include "Parallel.hpp"
+#include "TcamWriter.hpp"
 
 using namespace std;
 
@@ -35,25 +36,7 @@ using namespace std;
  */
 std::string dirpe_value_chunk(int x, int W)
 {
-    int max_val = (1 << W); // 2^W
-    int num_zeros = max_val - x - 1;
-    int num_ones = x;
-
-    std::string result;
-    result.reserve(max_val - 1);
-
-    // Append '0's
-    for (int i = 0; i < num_zeros; i++)
-    {
-        result += '0';
-    }
-    // Append '1's
-    for (int i = 0; i < num_ones; i++)
-    {
-        result += '1';
-    }
-
-    return result;
+    return fence_pattern<FENCE_MAX_BITS>(fence_chunk_value(x, W), W).to_string();
 }
 
 /**
@@ -72,31 +55,7 @@ std::string dirpe_range_chunk(int s, int e, int W)
 {
     assert(s <= e && "DIRPE range encoding requires s <= e within chunk");
 
-    int max_val = (1 << W); // 2^W
-    int num_zeros = max_val - e - 1;
-    int num_stars = e - s;
-    int num_ones = s;
-
-    std::string result;
-    result.reserve(max_val - 1);
-
-    // Append '0's
-    for (int i = 0; i < num_zeros; i++)
-    {
-        result += '0';
-    }
-    // Append '*'s
-    for (int i = 0; i < num_stars; i++)
-    {
-        result += '*';
-    }
-    // Append '1's
-    for (int i = 0; i < num_ones; i++)
-    {
-        result += '1';
-    }
-
-    return result;
+    return fence_pattern<FENCE_MAX_BITS>(fence_chunk_range(s, e, W), W).to_string();
 }
 
 // ===============================================================================
@@ -331,36 +290,38 @@ std::vector<std::pair<uint16_t, uint16_t>> chunk_aligned_decomposition(
 // ===============================================================================
 
 /**
- * Encode a single value using DIRPE (chunk-wise concatenation)
+ * Encode a single subrange (already chunk-aligned) into a packed pattern.
+ * Each chunk is a table-driven fence (see Fence.hpp) shifted in from the right.
  */
-std::string dirpe_encode_value(uint16_t v, const DIRPEConfig &config)
+static FencePattern dirpe_pack_subrange(uint16_t s, uint16_t e, const DIRPEConfig &config)
 {
-    std::string result;
+    assert(config.W <= FENCE_MAX_C && "DIRPE chunk width must be at most 4");
+
+    FencePattern result = FencePattern::any(0);
+    const int chunk_len = fence_len(config.W);
 
     for (int i = 0; i < config.num_chunks(); i++)
     {
-        int chunk_val = get_chunk(v, i, config);
-        result += dirpe_value_chunk(chunk_val, config.W);
+        FenceChunk ch = fence_chunk_range(get_chunk(s, i, config), get_chunk(e, i, config), config.W);
+        result.mask = (result.mask << chunk_len) | ch.mask;
+        result.value = (result.value << chunk_len) | ch.value;
+        result.width += chunk_len;
     }
 
     return result;
 }
 
 /**
- * Encode a single subrange (already chunk-aligned) using DIRPE
+ * Encode a single value using DIRPE (chunk-wise concatenation)
  */
-static std::string dirpe_encode_subrange(uint16_t s, uint16_t e, const DIRPEConfig &config)
+std::string dirpe_encode_value(uint16_t v, const DIRPEConfig &config)
 {
-    std::string result;
-
-    for (int i = 0; i < config.num_chunks(); i++)
-    {
-        int s_chunk = get_chunk(s, i, config);
-        int e_chunk = get_chunk(e, i, config);
-        result += dirpe_range_chunk(s_chunk, e_chunk, config.W);
-    }
+    return dirpe_value_pattern(v, config).to_string();
+}
 
-    return result;
+FencePattern dirpe_value_pattern(uint16_t v, const DIRPEConfig &config)
+{
+    return dirpe_pack_subrange(v, v, config);
 }
 
 /**
@@ -376,8 +337,7 @@ DIRPEResult dirpe_encode_range(uint16_t s, uint16_t e, const DIRPEConfig &config
     // Step 2: Encode each subrange
     for (const auto &subrange : result.subranges)
     {
-        std::string encoding = dirpe_encode_subrange(subrange.first, subrange.second, config);
-        result.encodings.push_back(encoding);
+        result.encodings.push_back(dirpe_pack_subrange(subrange.first, subrange.second, config));
     }
 
     return result;
@@ -434,31 +394,69 @@ void print_dirpe_result(const DIRPEResult &result, const std::string &label)
 /**
  * Encode port table using DIRPE (similar to SRGE)
  */
-std::vector<DIRPEPort> DIRPE(const std::vector<PortRule> &port_table,
-                             int chunk_width)
+// One intern table for all configs; the key carries (W, total_bits)
+static RangeInternTable<DIRPEResult> g_dirpe_intern;
+
+static DIRPEHandle dirpe_intern(uint16_t lo, uint16_t hi, const DIRPEConfig &config)
+{
+    uint32_t params = ((uint32_t)config.W << 8) | (uint32_t)config.total_bits;
+    return g_dirpe_intern.intern(params, lo, hi, [&config](uint16_t s, uint16_t e)
+                                 { return dirpe_encode_range(s, e, config); });
+}
+
+RangeInternStats dirpe_intern_stats()
+{
+    return g_dirpe_intern.stats();
+}
+
+void dirpe_intern_clear()
+{
+    g_dirpe_intern.clear();
+}
+
+std::vector<DIRPEPort> DIRPE(const PortTable &port_table,
+                             int chunk_width, int threads)
+{
+    ThreadPool pool(threads);
+    return DIRPE(port_table, chunk_width, pool);
+}
+
+std::vector<DIRPEPort> DIRPE(const PortTable &port_table, int chunk_width, ThreadPool &pool)
 {
-    std::vector<DIRPEPort> dirpe_ports;
+    // Pre-sized so parallel workers fill slots by index (input order preserved)
+    std::vector<DIRPEPort> dirpe_ports(port_table.size());
+    if (port_table.empty())
+    {
+        return dirpe_ports;
+    }
+
+    // Port columns of the RuleTable, read in place
+    const uint16_t *src_lo = port_table.src_port_lo();
+    const uint16_t *src_hi = port_table.src_port_hi();
+    const uint16_t *dst_lo = port_table.dst_port_lo();
+    const uint16_t *dst_hi = port_table.dst_port_hi();
+    const uint32_t *priority = port_table.priority();
+    const uint16_t *action_id = port_table.action_id();
 
     DIRPEConfig config;
     config.W = chunk_width;
     config.total_bits = 16; // Standard port range is 16-bit
 
-    for (const auto &pr : port_table)
+    parallel_for_each_index(port_table.size(), pool, [&](size_t i)
     {
-        DIRPEPort dp;
-        dp.src_port_lo = pr.src_port_lo;
-        dp.src_port_hi = pr.src_port_hi;
-        dp.dst_port_lo = pr.dst_port_lo;
-        dp.dst_port_hi = pr.dst_port_hi;
-        dp.priority = pr.priority;
-        dp.action = pr.action;
+        DIRPEPort &dp = dirpe_ports[i];
+        dp.src_port_lo = src_lo[i];
+        dp.src_port_hi = src_hi[i];
+        dp.dst_port_lo = dst_lo[i];
+        dp.dst_port_hi = dst_hi[i];
+        dp.priority = priority[i];
+        dp.rid = port_table.rid(i);
+        dp.action_id = action_id[i];
 
         // Encode source and destination port ranges
-        dp.src_dirpe = dirpe_encode_range(pr.src_port_lo, pr.src_port_hi, config);
-        dp.dst_dirpe = dirpe_encode_range(pr.dst_port_lo, pr.dst_port_hi, config);
-
-        dirpe_ports.push_back(dp);
-    }
+        dp.src_dirpe = dirpe_intern(src_lo[i], src_hi[i], config);
+        dp.dst_dirpe = dirpe_intern(dst_lo[i], dst_hi[i], config);
+    });
 
     return dirpe_ports;
 }
@@ -473,15 +471,16 @@ std::vector<DIRPETCAM_Entry> generate_dirpe_tcam_entries(const std::vector<DIRPE
     for (const auto &dp : dirpe_ports)
     {
         // Cartesian product: each src_pattern × each dst_pattern
-        for (const auto &src_pat : dp.src_dirpe.encodings)
+        for (const auto &src_pat : dp.src_dirpe->encodings)
         {
-            for (const auto &dst_pat : dp.dst_dirpe.encodings)
+            for (const auto &dst_pat : dp.dst_dirpe->encodings)
             {
                 DIRPETCAM_Entry entry;
                 entry.src_pattern = src_pat;
                 entry.dst_pattern = dst_pat;
                 entry.priority = dp.priority;
-                entry.action = dp.action;
+                entry.rid = dp.rid;
+                entry.action_id = dp.action_id;
                 tcam_entries.push_back(entry);
             }
         }
@@ -491,114 +490,122 @@ std::vector<DIRPETCAM_Entry> generate_dirpe_tcam_entries(const std::vector<DIRPE
 }
 
 /**
- * Print DIRPE TCAM rules to file or stdout
+ * Streaming DIRPE TCAM rule file: header, batches, footer
  */
-void print_dirpe_tcam_rules(const std::vector<DIRPETCAM_Entry> &tcam_entries,
-                            const std::vector<IPRule> &ip_table,
-                            const std::string &output_file)
+bool DIRPETcamStream::open(const std::string &output_file)
 {
-    // Determine output stream
-    std::ostream *out_stream = &std::cout;
-    std::ofstream file_stream;
-
-    if (!output_file.empty())
+    total_ = 0;
+    if (!out_.open(output_file))
     {
-        // Create output directory if needed
-        size_t last_slash = output_file.find_last_of("/");
-        if (last_slash != std::string::npos)
-        {
-            std::string dir = output_file.substr(0, last_slash);
-            system(("mkdir -p " + dir).c_str());
-        }
+        return false;
+    }
 
-        file_stream.open(output_file);
-        if (!file_stream.is_open())
-        {
-            std::cerr << "[ERROR] Cannot open output file: " << output_file << "\n";
-            return;
-        }
-        out_stream = &file_stream;
+    out_.put_literal("=== DIRPE TCAM Rules (Chunk-based Ternary Format) ===\n\n");
+    return true;
+}
+
+void DIRPETcamStream::write(const std::vector<DIRPETCAM_Entry> &tcam_entries, const IPTable &ip_table,
+                           std::vector<RuleOutputSize> *per_rule)
+{
+    if (!out_.is_open())
+    {
+        return;
     }
 
-    *out_stream << "=== DIRPE TCAM Rules (Chunk-based Ternary Format) ===\n\n";
+    IPRuleIndex ip_index(ip_table);
+
+    // For W=2: 24 bits (8 chunks × 3 bits per chunk); shorter patterns get leading zeros
+    const int expected_len = 24;
 
     for (size_t i = 0; i < tcam_entries.size(); i++)
     {
         const auto &entry = tcam_entries[i];
+        uint64_t start = out_.offset();
 
-        // Find corresponding IP rule by priority
-        const IPRule *ip_rule = nullptr;
-        for (const auto &ipr : ip_table)
-        {
-            if (ipr.priority == entry.priority)
-            {
-                ip_rule = &ipr;
-                break;
-            }
-        }
-
-        if (!ip_rule)
+        // Find corresponding IP rule (rid, falling back to priority)
+        IPRule ip_rule;
+        if (!ip_index.find(entry.rid, entry.priority, ip_rule))
         {
             std::cerr << "[WARN] No IP rule found for priority " << entry.priority << "\n";
             continue;
         }
 
         // Format: @SRC_IP/MASK  DST_IP/MASK  SPORT_PATTERN  DPORT_PATTERN  PROTO/MASK  ACTION
-        *out_stream << "@";
-
-        // Source IP
-        uint32_t sip = ip_rule->src_ip_lo;
-        *out_stream << ((sip >> 24) & 0xFF) << "."
-                    << ((sip >> 16) & 0xFF) << "."
-                    << ((sip >> 8) & 0xFF) << "."
-                    << (sip & 0xFF) << "/" << ip_rule->src_prefix_len;
-
-        *out_stream << "     ";
-
-        // Destination IP
-        uint32_t dip = ip_rule->dst_ip_lo;
-        *out_stream << ((dip >> 24) & 0xFF) << "."
-                    << ((dip >> 16) & 0xFF) << "."
-                    << ((dip >> 8) & 0xFF) << "."
-                    << (dip & 0xFF) << "/" << ip_rule->dst_prefix_len;
-
-        *out_stream << "         ";
-
-        // Source port pattern (full width: 8 chunks × 3 bits = 24 bits for W=2)
-        std::string src_full = entry.src_pattern;
-        // For W=2: should be 24 bits (8 chunks × 3 bits per chunk)
-        // Pad with leading zeros if shorter
-        int expected_len = 24; // 16 bits / 2 bits per chunk × 3 encoded bits
-        while (src_full.length() < expected_len)
-        {
-            src_full = "0" + src_full;
-        }
-        *out_stream << src_full << " ";
+        out_.put('@');
+        out_.put_ipv4(ip_rule.src_ip_lo);
+        out_.put('/');
+        out_.put_int(ip_rule.src_prefix_len);
+        out_.put_literal("     ");
+
+        out_.put_ipv4(ip_rule.dst_ip_lo);
+        out_.put('/');
+        out_.put_int(ip_rule.dst_prefix_len);
+        out_.put_literal("         ");
+
+        // Source / destination port patterns
+        out_.put_pattern(entry.src_pattern, expected_len);
+        out_.put(' ');
+        out_.put_pattern(entry.dst_pattern, expected_len);
+        out_.put(' ');
+
+        // Protocol
+        out_.put_literal("0x");
+        out_.put_hex2(ip_rule.proto);
+        out_.put_literal("/0xFF   ");
+
+        // Action
+        out_.put(ip_table.action(entry.action_id));
+        out_.put('\n');
 
-        // Destination port pattern (full width: 8 chunks × 3 bits = 24 bits for W=2)
-        std::string dst_full = entry.dst_pattern;
-        while (dst_full.length() < expected_len)
+        if (per_rule)
         {
-            dst_full = "0" + dst_full;
+            RuleOutputSize &size = (*per_rule)[entry.rid];
+            size.bytes += (uint32_t)(out_.offset() - start);
+            size.entries++;
         }
-        *out_stream << dst_full << " ";
+    }
 
-        // Protocol
-        *out_stream << "0x" << std::hex << std::setw(2) << std::setfill('0')
-                    << (int)ip_rule->proto << "/0xFF   ";
+    total_ += tcam_entries.size();
+}
 
-        // Action
-        *out_stream << std::dec << entry.action;
+void DIRPETcamStream::write_raw(const char *data, size_t n, uint64_t entries)
+{
+    if (!out_.is_open())
+    {
+        return;
+    }
+    out_.put(data, n);
+    total_ += entries;
+}
 
-        *out_stream << "\n";
+TcamWriteStats DIRPETcamStream::close()
+{
+    if (!out_.is_open())
+    {
+        return TcamWriteStats();
     }
 
-    *out_stream << "\n=== Total DIRPE TCAM Entries: " << tcam_entries.size() << " ===\n";
+    out_.put_literal("\n=== Total DIRPE TCAM Entries: ");
+    out_.put_uint(total_);
+    out_.put_literal(" ===\n");
 
-    if (file_stream.is_open())
+    return out_.close();
+}
+
+/**
+ * Print DIRPE TCAM rules to file or stdout
+ */
+TcamWriteStats print_dirpe_tcam_rules(const std::vector<DIRPETCAM_Entry> &tcam_entries,
+                                      const IPTable &ip_table,
+                                      const std::string &output_file)
+{
+    DIRPETcamStream stream;
+    if (!stream.open(output_file))
     {
-        file_stream.close();
+        return TcamWriteStats();
     }
+    stream.write(tcam_entries, ip_table);
+    return stream.close();
 }
 
 // ===============================================================================
@@ -669,7 +676,7 @@ int main()
     {
         cout << "  [" << result.subranges[i].first << ", "
              << result.subranges[i].second << "] -> "
-             << format_with_separators(result.encodings[i], config.W) << endl;
+             << format_with_separators(result.encodings[i].to_string(), config.W) << endl;
     }
     cout << endl;
 
@@ -687,7 +694,7 @@ int main()
     {
         for (size_t i = 0; i < expected.size(); i++)
         {
-            if (result.encodings[i] != expected[i])
+            if (result.encodings[i].to_string() != expected[i])
             {
                 test_passed = false;
                 cout << "[FAIL] Encoding " << i << ": got " << result.encodings[i]
@@ -732,8 +739,8 @@ int main()
     bool test1_pass = (r_1_6.subranges.size() == 2 &&
                        r_1_6.subranges[0] == make_pair<uint16_t, uint16_t>(1, 3) &&
                        r_1_6.subranges[1] == make_pair<uint16_t, uint16_t>(4, 6) &&
-                       r_1_6.encodings[0] == "000**1" &&
-                       r_1_6.encodings[1] == "0010**");
+                       r_1_6.encodings[0].to_string() == "000**1" &&
+                       r_1_6.encodings[1].to_string() == "0010**");
     cout << (test1_pass ? "[PASS]" : "[FAIL]") << " Test 1: [1,6]\n\n";
 
     // =========================================================================
@@ -12,6 +12,10 @@
 #include <string>
 #include <cstdint>
 #include "Loader.hpp"
+#include "Ternary.hpp"
+#include "Parallel.hpp"
+#include "RangeIntern.hpp"
+#include "TcamWriter.hpp"
 
 // ===============================================================================
 // DIRPE Configuration
@@ -31,7 +35,7 @@ struct DIRPEConfig {
 // ===============================================================================
 
 struct DIRPEResult {
-    std::vector<std::string> encodings;  // List of ternary encodings
+    std::vector<FencePattern> encodings;  // List of packed ternary encodings
     
     // For debugging/verification
     std::vector<std::pair<uint16_t, uint16_t>> subranges;  // Decomposed subranges
@@ -73,6 +77,9 @@ std::vector<std::pair<uint16_t, uint16_t>> chunk_aligned_decomposition(
 // Encode a single value using DIRPE (chunk-wise)
 std::string dirpe_encode_value(uint16_t v, const DIRPEConfig& config);
 
+// Packed form of dirpe_encode_value (every symbol is a care bit): the lookup key of v
+FencePattern dirpe_value_pattern(uint16_t v, const DIRPEConfig& config);
+
 // Encode a range [s, e] using DIRPE (with automatic decomposition)
 DIRPEResult dirpe_encode_range(uint16_t s, uint16_t e, const DIRPEConfig& config);
 
@@ -93,6 +100,9 @@ std::string format_with_separators(const std::string& encoding, int W);
 // Module 5: Port Processing (similar to SRGE interface)
 // ===============================================================================
 
+// Interned DIRPE result: every rule with the same port range shares one encoding
+using DIRPEHandle = RangeInternTable<DIRPEResult>::Handle;
+
 // Structure for DIRPE-encoded port (similar to GrayCodedPort)
 struct DIRPEPort {
     uint16_t src_port_lo;
@@ -100,30 +110,59 @@ struct DIRPEPort {
     uint16_t dst_port_lo;
     uint16_t dst_port_hi;
     uint32_t priority;
-    std::string action;
+    uint32_t rid = UINT32_MAX; // RuleTable row (PortRule::rid)
+    uint16_t action_id = 0;    // RuleTable::actions index
     
-    // DIRPE results for source and destination port ranges
-    DIRPEResult src_dirpe;
-    DIRPEResult dst_dirpe;
+    // DIRPE results for source and destination port ranges (interned, shared across rules)
+    DIRPEHandle src_dirpe;
+    DIRPEHandle dst_dirpe;
 };
 
 // Structure for DIRPE TCAM entry (port dimension only)
 struct DIRPETCAM_Entry {
-    std::string src_pattern;
-    std::string dst_pattern;
+    FencePattern src_pattern;
+    FencePattern dst_pattern;
     uint32_t priority;
-    std::string action;
+    uint32_t rid = UINT32_MAX; // RuleTable row, used by the writer's join
+    uint16_t action_id = 0;    // Text is looked up by the writer
 };
 
 // Encode port table using DIRPE
-std::vector<DIRPEPort> DIRPE(const std::vector<PortRule>& port_table, 
-                              int chunk_width = 2);
+// threads: 1 = serial, 0 = all hardware threads; output order is the same either way
+std::vector<DIRPEPort> DIRPE(const PortTable& port_table, 
+                              int chunk_width = 2, int threads = 1);
+
+// Same, on the threads of a pool kept by the caller (e.g. across streaming batches)
+std::vector<DIRPEPort> DIRPE(const PortTable &port_table, int chunk_width, ThreadPool &pool);
+
+// Distinct ranges and hit rate of the DIRPE range intern table
+RangeInternStats dirpe_intern_stats();
+
+// Drop all interned ranges and reset the stats (e.g. between streaming batches)
+void dirpe_intern_clear();
 
 // Generate TCAM entries from DIRPE-encoded ports
 std::vector<DIRPETCAM_Entry> generate_dirpe_tcam_entries(const std::vector<DIRPEPort>& dirpe_ports);
 
-// Print DIRPE TCAM rules to file or stdout
-void print_dirpe_tcam_rules(const std::vector<DIRPETCAM_Entry>& tcam_entries,
-                            const std::vector<IPRule>& ip_table,
-                            const std::string& output_file = "");
+// Streaming form of print_dirpe_tcam_rules: the same file, written batch by batch
+class DIRPETcamStream
+{
+public:
+    bool open(const std::string &output_file);  // header; false if the file cannot be created
+    void write(const std::vector<DIRPETCAM_Entry> &tcam_entries, const IPTable &ip_table,
+               std::vector<RuleOutputSize> *per_rule = nullptr);
+    void write_raw(const char *data, size_t n, uint64_t entries);
+    TcamWriteStats close();                     // footer with the running total
+
+    uint64_t offset() const { return out_.offset(); }
+
+private:
+    TcamWriter out_;
+    uint64_t total_ = 0;
+};
+
+// Print DIRPE TCAM rules to file or stdout; returns bytes written and throughput
+TcamWriteStats print_dirpe_tcam_rules(const std::vector<DIRPETCAM_Entry>& tcam_entries,
+                                      const IPTable& ip_table,
+                                      const std::string& output_file = "");
 
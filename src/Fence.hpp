@@ -0,0 +1,142 @@
+/** *************************************************************/
+// @Name: Fence.hpp
+// @Function: Bit-parallel fence (thermometer) chunk kernels for DIRPE and CGFE
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-23
+// @Description: Packed encode / reflect of one c-bit chunk
+/************************************************************* */
+
+#pragma once
+
+#include <cstdint>
+#include "Ternary.hpp"
+
+// ===============================================================================
+// Fence Chunk Layout
+// ===============================================================================
+//
+// A c-bit chunk value range [s, e] encodes to L = 2^c - 1 symbols:
+//   F([s, e]) = '0'^(L - e) + '*'^(e - s) + '1'^s
+// Packed (symbol 0 is bit L-1):
+//   value = low(s)
+//   mask  = low(L) & ~(low(e) ^ low(s))     // '*' occupies bits [s, e)
+
+constexpr int FENCE_MAX_C = 4; // Largest chunk width with a lookup table (L = 15)
+
+constexpr int fence_len(int c) { return (1 << c) - 1; }
+
+struct FenceChunk
+{
+    uint16_t value;
+    uint16_t mask;
+};
+
+namespace fence_detail
+{
+
+constexpr uint16_t low(int n) { return (uint16_t)((1u << n) - 1); }
+
+constexpr FenceChunk make_range(int s, int e, int c)
+{
+    return FenceChunk{low(s), (uint16_t)(low(fence_len(c)) & ~(low(e) ^ low(s)))};
+}
+
+// [s][e] -> packed chunk, for every c-bit range (s <= e)
+template <int c>
+struct RangeTable
+{
+    static constexpr int V = 1 << c;
+    FenceChunk chunk[V][V] = {};
+
+    constexpr RangeTable()
+    {
+        for (int s = 0; s < V; ++s)
+            for (int e = s; e < V; ++e)
+                chunk[s][e] = make_range(s, e, c);
+    }
+};
+
+template <int c>
+constexpr RangeTable<c> range_table{};
+
+struct ByteReverseTable
+{
+    uint8_t rev[256] = {};
+
+    constexpr ByteReverseTable()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            int r = 0;
+            for (int b = 0; b < 8; ++b)
+                r |= ((i >> b) & 1) << (7 - b);
+            rev[i] = (uint8_t)r;
+        }
+    }
+};
+
+constexpr ByteReverseTable byte_reverse{};
+
+// Reverse the low n bits of x (n <= 16)
+constexpr uint16_t reverse_bits(uint16_t x, int n)
+{
+    uint16_t r = (uint16_t)((byte_reverse.rev[x & 0xFF] << 8) | byte_reverse.rev[x >> 8]);
+    return (uint16_t)(r >> (16 - n));
+}
+
+} // namespace fence_detail
+
+// ===============================================================================
+// Chunk Kernels
+// ===============================================================================
+
+// F([s, e]) for one c-bit chunk (table lookup for c <= 4)
+inline FenceChunk fence_chunk_range(int s, int e, int c)
+{
+    switch (c)
+    {
+    case 1: return fence_detail::range_table<1>.chunk[s][e];
+    case 2: return fence_detail::range_table<2>.chunk[s][e];
+    case 3: return fence_detail::range_table<3>.chunk[s][e];
+    case 4: return fence_detail::range_table<4>.chunk[s][e];
+    default: return fence_detail::make_range(s, e, c);
+    }
+}
+
+// F(x) = F([x, x])
+inline FenceChunk fence_chunk_value(int x, int c) { return fence_chunk_range(x, x, c); }
+
+// Reflection [s, e] -> [L - e, L - s]: bit-reverse the chunk, complement care bits
+inline FenceChunk fence_chunk_reflect(FenceChunk ch, int c)
+{
+    const int L = fence_len(c);
+    uint16_t mask = fence_detail::reverse_bits(ch.mask, L);
+    uint16_t value = fence_detail::reverse_bits(ch.value, L);
+    return FenceChunk{(uint16_t)(mask & ~value), mask};
+}
+
+// ===============================================================================
+// Pattern-level Helpers
+// ===============================================================================
+
+// Single chunk as a pattern of L symbols
+template <int N>
+inline Ternary<N> fence_pattern(FenceChunk ch, int c)
+{
+    return Ternary<N>::from_masks(ch.value, ch.mask, fence_len(c));
+}
+
+// Chunk prepended in front of tail
+template <int N>
+inline Ternary<N> fence_prepend(FenceChunk ch, int c, const Ternary<N> &tail)
+{
+    return tail.prepend(ch.value, ch.mask, fence_len(c));
+}
+
+// Leading chunk of a pattern
+template <int N>
+inline FenceChunk fence_front(const Ternary<N> &p, int c)
+{
+    const int shift = p.width - fence_len(c);
+    return FenceChunk{(uint16_t)(p.value >> shift), (uint16_t)((p.mask >> shift) & fence_detail::low(fence_len(c)))};
+}
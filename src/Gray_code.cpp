@@ -7,12 +7,12 @@
 
 #include <vector>
 #include <iostream>
-#include <fstream>
-#include <iomanip>
 #include <bitset>
 #include <algorithm>
 #include "Gray_code.hpp"
 #include "Loader.hpp"
+#include "Parallel.hpp"
+#include "TcamWriter.hpp"
 
 using namespace std;
 
@@ -196,39 +196,91 @@ uint32_t binary_range_size(uint16_t bs, uint16_t be)
 }
 
 /**
- * @brief 构建覆盖区间的 ternary pattern (Gray code 形式)
+ * @brief 闭式计算 binary 区间 [bs, be] 内所有 Gray code 的按位 AND / OR
+ *
+ * Gray 第 i 位 g_i(b) = b_i ^ b_{i+1}，以 2^(i+2) 为周期取值 0,1,1,0，
+ * 等价于 (b + 2^i) 的第 i+1 位。因此 g_i 在区间内恒定
+ * 当且仅当 bs + 2^i 与 be + 2^i 落在同一个 2^(i+1) 块内。
+ * 复杂度 O(bits)，与区间大小无关。
  */
-string build_pattern_for_range(uint16_t bs, uint16_t be, int bits)
+static void gray_range_masks(uint16_t bs, uint16_t be, int bits,
+                             uint16_t &all_ones, uint16_t &all_zeros)
 {
-    if (bs > be)
-        return "";
+    all_ones = 0x0000;
+    all_zeros = 0x0000;
 
-    // 计算区间内所有 Gray code 的共同特征
-    uint16_t all_ones = 0xFFFF;
-    uint16_t all_zeros = 0x0000;
+    for (int i = 0; i < bits; ++i)
+    {
+        uint32_t half = 1u << i;
+        uint32_t s_blk = ((uint32_t)bs + half) >> (i + 1);
+        uint32_t e_blk = ((uint32_t)be + half) >> (i + 1);
 
-    for (uint16_t b = bs; b <= be; ++b)
+        if (s_blk != e_blk)
+        {
+            all_zeros |= (uint16_t)half; // 该位在区间内变化
+        }
+        else if (s_blk & 1)
+        {
+            all_ones |= (uint16_t)half; // 恒为 1
+            all_zeros |= (uint16_t)half;
+        }
+    }
+}
+
+#ifdef SRGE_DEBUG_SCAN
+/**
+ * @brief 逐点扫描版本 (O(range))，仅用于与闭式版本交叉校验
+ */
+static void gray_range_masks_scan(uint16_t bs, uint16_t be, int bits,
+                                  uint16_t &all_ones, uint16_t &all_zeros)
+{
+    all_ones = 0xFFFF;
+    all_zeros = 0x0000;
+
+    for (uint32_t b = bs; b <= be; ++b)
     {
-        uint16_t g = binary_to_gray(b);
+        uint16_t g = binary_to_gray((uint16_t)b);
         all_ones &= g;
         all_zeros |= g;
     }
 
-    string pattern;
-    for (int i = bits - 1; i >= 0; --i)
-    {
-        bool is_one = (all_ones >> i) & 1;
-        bool is_zero = !((all_zeros >> i) & 1);
+    uint16_t width_mask = (uint16_t)((1u << bits) - 1);
+    all_ones &= width_mask;
+    all_zeros &= width_mask;
+}
+#endif
 
-        if (is_one)
-            pattern += '1';
-        else if (is_zero)
-            pattern += '0';
-        else
-            pattern += '*';
+static void gray_range_masks_checked(uint16_t bs, uint16_t be, int bits,
+                                     uint16_t &all_ones, uint16_t &all_zeros)
+{
+    gray_range_masks(bs, be, bits, all_ones, all_zeros);
+
+#ifdef SRGE_DEBUG_SCAN
+    uint16_t scan_ones = 0, scan_zeros = 0;
+    gray_range_masks_scan(bs, be, bits, scan_ones, scan_zeros);
+    if (scan_ones != all_ones || scan_zeros != all_zeros)
+    {
+        cerr << "[SRGE_DEBUG_SCAN] mask mismatch on [" << bs << ", " << be << "]\n";
+        abort();
     }
+#endif
+}
+
+/**
+ * @brief 构建覆盖区间的 ternary pattern (Gray code 形式)
+ */
+GrayPattern build_pattern_for_range(uint16_t bs, uint16_t be, int bits)
+{
+    if (bs > be)
+        return GrayPattern::any(0);
+
+    // 计算区间内所有 Gray code 的共同特征
+    uint16_t all_ones = 0, all_zeros = 0;
+    gray_range_masks_checked(bs, be, bits, all_ones, all_zeros);
 
-    return pattern;
+    // care 位 = 恒为 1 或恒为 0 的位
+    uint16_t care = all_ones | (uint16_t)~all_zeros;
+    return GrayPattern::from_masks(all_ones, care, bits);
 }
 
 /**
@@ -242,18 +294,15 @@ bool is_valid_gray_hypercube(uint16_t bs, uint16_t be, int bits)
 {
     if (bs > be)
         return false;
-    uint32_t size = be - bs + 1;
+    uint32_t size = (uint32_t)be - bs + 1;
 
-    // 计算区间内 Gray codes 的变化位
-    uint16_t all_ones = 0xFFFF;
-    uint16_t all_zeros = 0x0000;
+    // hypercube 的大小必须是 2 的幂次
+    if (size & (size - 1))
+        return false;
 
-    for (uint16_t b = bs; b <= be; ++b)
-    {
-        uint16_t g = binary_to_gray(b);
-        all_ones &= g;
-        all_zeros |= g;
-    }
+    // 计算区间内 Gray codes 的变化位
+    uint16_t all_ones = 0, all_zeros = 0;
+    gray_range_masks_checked(bs, be, bits, all_ones, all_zeros);
 
     // wildcard 位 = all_zeros 中为 1 且 all_ones 中为 0 的位
     uint16_t wildcard_bits = all_zeros & ~all_ones;
@@ -349,16 +398,20 @@ uint16_t greedy_max_hypercube(uint16_t bs, uint16_t be, int bits)
  * @param be 结束 binary 值
  * @param bits 位宽
  * @param results 输出 pattern 集合
+ * @param calls 递归调用计数。不是 O(bits^2)：几乎每次调用输出一个 pattern，
+ *              调用数随输出条目数增长 (1025:65535 为 1855 次，1:65535 为 1922 次)
  */
-void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &results)
+void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<GrayPattern> &results,
+                         uint32_t &calls)
 {
     if (bs > be)
         return;
+    ++calls;
 
     // Base case: 单点
     if (bs == be)
     {
-        results.push_back(gray_to_string(binary_to_gray(bs), bits));
+        results.push_back(GrayPattern::exact(binary_to_gray(bs), bits));
         return;
     }
 
@@ -373,22 +426,33 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
     uint16_t sg = binary_to_gray(bs);
     uint16_t eg = binary_to_gray(be);
     int lca_depth = compute_deepest_gray_lca(sg, eg, bits);
-    int flip_bit_pos = bits - 1 - lca_depth;
 
     // 找 pivot: Gray 序列中第一个在 lca_depth 位与 sg 不同的值
+    // LCA 之上的 Gray 位相同 => binary 高位相同，flip 位在区间内只翻转一次，
+    // 翻转点就是 bs 所在 2^(flip_bit_pos+1) 块内的中点，可直接计算
+    uint16_t pivot = compute_pivot_binary(sg, eg, lca_depth, bits);
+
+#ifdef SRGE_DEBUG_SCAN
+    int flip_bit_pos = bits - 1 - lca_depth;
     int sg_bit = (sg >> flip_bit_pos) & 1;
-    uint16_t pivot = 0xFFFF;
-    for (uint16_t b = bs; b <= be; b++)
+    uint32_t scan_pivot = 0x10000;
+    for (uint32_t b = bs; b <= be; b++)
     {
-        uint16_t g = binary_to_gray(b);
+        uint16_t g = binary_to_gray((uint16_t)b);
         if (((g >> flip_bit_pos) & 1) != sg_bit)
         {
-            pivot = b;
+            scan_pivot = b;
             break;
         }
     }
+    if (scan_pivot != pivot)
+    {
+        cerr << "[SRGE_DEBUG_SCAN] pivot mismatch on [" << bs << ", " << be << "]\n";
+        abort();
+    }
+#endif
 
-    if (pivot == 0xFFFF)
+    if (pivot <= bs || pivot > be)
     {
         // 无法分裂，作为 hypercube 输出
         results.push_back(build_pattern_for_range(bs, be, bits));
@@ -412,8 +476,8 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
         uint32_t merge_size = merge_end - right_bs + 1;
 
         // 生成 pattern 并反射
-        string pattern = build_pattern_for_range(right_bs, merge_end, bits);
-        pattern[lca_depth] = '*'; // 反射：将 LCA 位变为 wildcard
+        GrayPattern pattern = build_pattern_for_range(right_bs, merge_end, bits);
+        pattern.set_wildcard(lca_depth); // 反射：将 LCA 位变为 wildcard
         results.push_back(pattern);
 
         // 左侧消耗对称部分：从右往左数 merge_size 个
@@ -440,8 +504,8 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
                 uint16_t l_sym_bs = left_remain_be - r_merge_size + 1;
 
                 // 检查是否能反射合并
-                string r_pat = build_pattern_for_range(right_remain_bs, r_merge_end, bits);
-                string l_pat = build_pattern_for_range(l_sym_bs, left_remain_be, bits);
+                GrayPattern r_pat = build_pattern_for_range(right_remain_bs, r_merge_end, bits);
+                GrayPattern l_pat = build_pattern_for_range(l_sym_bs, left_remain_be, bits);
 
                 // 计算两个区间的 LCA
                 uint16_t r_g = binary_to_gray(right_remain_bs);
@@ -449,50 +513,40 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
                 int sub_lca = compute_deepest_gray_lca(l_g, r_g, bits);
 
                 // 检查除 sub_lca 位外其他位是否相同
-                bool can_merge = true;
-                for (int i = 0; i < bits; i++)
-                {
-                    if (i == sub_lca)
-                        continue;
-                    if (l_pat[i] != r_pat[i])
-                    {
-                        can_merge = false;
-                        break;
-                    }
-                }
+                bool can_merge = l_pat.equal_except(r_pat, sub_lca);
 
                 if (can_merge)
                 {
                     // 合并并反射
-                    l_pat[sub_lca] = '*';
+                    l_pat.set_wildcard(sub_lca);
                     results.push_back(l_pat);
 
                     // 处理左侧剩余的剩余
                     if (l_sym_bs > left_bs)
                     {
-                        srge_recursive_impl(left_bs, l_sym_bs - 1, bits, results);
+                        srge_recursive_impl(left_bs, l_sym_bs - 1, bits, results, calls);
                     }
 
                     // 处理右侧剩余的剩余
                     if (r_merge_end < right_be)
                     {
-                        srge_recursive_impl(r_merge_end + 1, right_be, bits, results);
+                        srge_recursive_impl(r_merge_end + 1, right_be, bits, results, calls);
                     }
                     return;
                 }
             }
 
             // 无法反射合并，分别递归
-            srge_recursive_impl(left_bs, left_remain_be, bits, results);
-            srge_recursive_impl(right_remain_bs, right_be, bits, results);
+            srge_recursive_impl(left_bs, left_remain_be, bits, results, calls);
+            srge_recursive_impl(right_remain_bs, right_be, bits, results, calls);
         }
         else if (has_left)
         {
-            srge_recursive_impl(left_bs, left_remain_be, bits, results);
+            srge_recursive_impl(left_bs, left_remain_be, bits, results, calls);
         }
         else if (has_right)
         {
-            srge_recursive_impl(right_remain_bs, right_be, bits, results);
+            srge_recursive_impl(right_remain_bs, right_be, bits, results, calls);
         }
     }
     else
@@ -502,8 +556,8 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
         uint32_t merge_size = merge_end - left_bs + 1;
 
         // 生成 pattern 并反射
-        string pattern = build_pattern_for_range(left_bs, merge_end, bits);
-        pattern[lca_depth] = '*'; // 反射
+        GrayPattern pattern = build_pattern_for_range(left_bs, merge_end, bits);
+        pattern.set_wildcard(lca_depth); // 反射
         results.push_back(pattern);
 
         // 右侧消耗对称部分：从左往右数 merge_size 个
@@ -518,30 +572,31 @@ void srge_recursive_impl(uint16_t bs, uint16_t be, int bits, vector<string> &res
         {
             if (right_remain_bs <= right_be)
             {
-                srge_recursive_impl(left_remain_bs, left_be, bits, results);
-                srge_recursive_impl(right_remain_bs, right_be, bits, results);
+                srge_recursive_impl(left_remain_bs, left_be, bits, results, calls);
+                srge_recursive_impl(right_remain_bs, right_be, bits, results, calls);
             }
             else
             {
-                srge_recursive_impl(left_remain_bs, left_be, bits, results);
+                srge_recursive_impl(left_remain_bs, left_be, bits, results, calls);
             }
         }
         else
         {
             if (right_remain_bs <= right_be)
             {
-                srge_recursive_impl(right_remain_bs, right_be, bits, results);
+                srge_recursive_impl(right_remain_bs, right_be, bits, results, calls);
             }
         }
     }
 }
 
 // 旧接口的包装
-void srge_recursive(uint16_t sg, uint16_t eg, int bits, vector<string> &results)
+void srge_recursive(uint16_t sg, uint16_t eg, int bits, vector<GrayPattern> &results,
+                    uint32_t &calls)
 {
     uint16_t bs = gray_to_binary(sg);
     uint16_t be = gray_to_binary(eg);
-    srge_recursive_impl(bs, be, bits, results);
+    srge_recursive_impl(bs, be, bits, results, calls);
 }
 
 // ============================================================
@@ -569,7 +624,7 @@ SRGEResult srge_encode(uint16_t sb, uint16_t eb, int bits)
     uint32_t max_val = (1u << bits) - 1;
     if (sb == 0 && eb == max_val)
     {
-        result.ternary_entries.push_back(string(bits, '*'));
+        result.ternary_entries.push_back(GrayPattern::any(bits));
         return result;
     }
 
@@ -581,7 +636,7 @@ SRGEResult srge_encode(uint16_t sb, uint16_t eb, int bits)
     // 但 Gray 码的 "连续" 定义需要论文明确
 
     // 调用递归分解
-    srge_recursive(sg, eg, bits, result.ternary_entries);
+    srge_recursive(sg, eg, bits, result.ternary_entries, result.recursion_calls);
 
     return result;
 }
@@ -590,36 +645,71 @@ SRGEResult srge_encode(uint16_t sb, uint16_t eb, int bits)
 // Module 8: Port Table SRGE Processing
 // ============================================================
 
-vector<GrayCodedPort> SRGE(const vector<PortRule> &port_table)
+// Ranges repeat heavily across rules; encode each (bits, lo, hi) once
+static RangeInternTable<SRGEResult> g_srge_intern;
+
+static SRGEHandle srge_intern(uint16_t lo, uint16_t hi)
 {
-    vector<GrayCodedPort> results;
+    return g_srge_intern.intern(GRAY_BITS, lo, hi, [](uint16_t s, uint16_t e)
+                                { return srge_encode(s, e, GRAY_BITS); });
+}
 
-    for (const auto &rule : port_table)
+RangeInternStats srge_intern_stats()
+{
+    return g_srge_intern.stats();
+}
+
+void srge_intern_clear()
+{
+    g_srge_intern.clear();
+}
+
+vector<GrayCodedPort> SRGE(const PortTable &port_table, int threads)
+{
+    ThreadPool pool(threads);
+    return SRGE(port_table, pool);
+}
+
+vector<GrayCodedPort> SRGE(const PortTable &port_table, ThreadPool &pool)
+{
+    // 每条规则写入自己的槽位，并行时输出顺序与输入一致
+    vector<GrayCodedPort> results(port_table.size());
+    if (port_table.empty())
+        return results;
+
+    // 直接读取 RuleTable 的端口列
+    const uint16_t *src_lo = port_table.src_port_lo();
+    const uint16_t *src_hi = port_table.src_port_hi();
+    const uint16_t *dst_lo = port_table.dst_port_lo();
+    const uint16_t *dst_hi = port_table.dst_port_hi();
+    const uint32_t *priority = port_table.priority();
+    const uint16_t *action_id = port_table.action_id();
+
+    parallel_for_each_index(port_table.size(), pool, [&](size_t i)
     {
-        GrayCodedPort gcp;
+        GrayCodedPort &gcp = results[i];
 
         // 保存原始端口范围
-        gcp.src_port_lo = rule.src_port_lo;
-        gcp.src_port_hi = rule.src_port_hi;
-        gcp.dst_port_lo = rule.dst_port_lo;
-        gcp.dst_port_hi = rule.dst_port_hi;
+        gcp.src_port_lo = src_lo[i];
+        gcp.src_port_hi = src_hi[i];
+        gcp.dst_port_lo = dst_lo[i];
+        gcp.dst_port_hi = dst_hi[i];
 
         // 计算 Gray 码
-        gcp.src_port_lo_gray_bs = bitset<16>(binary_to_gray(rule.src_port_lo));
-        gcp.src_port_hi_gray_bs = bitset<16>(binary_to_gray(rule.src_port_hi));
-        gcp.dst_port_lo_gray_bs = bitset<16>(binary_to_gray(rule.dst_port_lo));
-        gcp.dst_port_hi_gray_bs = bitset<16>(binary_to_gray(rule.dst_port_hi));
+        gcp.src_port_lo_gray_bs = bitset<16>(binary_to_gray(src_lo[i]));
+        gcp.src_port_hi_gray_bs = bitset<16>(binary_to_gray(src_hi[i]));
+        gcp.dst_port_lo_gray_bs = bitset<16>(binary_to_gray(dst_lo[i]));
+        gcp.dst_port_hi_gray_bs = bitset<16>(binary_to_gray(dst_hi[i]));
 
         // 应用 SRGE 编码
-        gcp.src_srge = srge_encode(rule.src_port_lo, rule.src_port_hi, GRAY_BITS);
-        gcp.dst_srge = srge_encode(rule.dst_port_lo, rule.dst_port_hi, GRAY_BITS);
+        gcp.src_srge = srge_intern(src_lo[i], src_hi[i]);
+        gcp.dst_srge = srge_intern(dst_lo[i], dst_hi[i]);
 
         // 复制其他字段
-        gcp.priority = rule.priority;
-        gcp.action = rule.action;
-
-        results.push_back(gcp);
-    }
+        gcp.priority = priority[i];
+        gcp.rid = port_table.rid(i);
+        gcp.action_id = action_id[i];
+    });
 
     return results;
 }
@@ -635,15 +725,16 @@ std::vector<GrayTCAM_Entry> generate_tcam_entries(const std::vector<GrayCodedPor
     for (const auto &gp : gray_ports)
     {
         // Cartesian product: each src_pattern × each dst_pattern
-        for (const auto &src_pat : gp.src_srge.ternary_entries)
+        for (const auto &src_pat : gp.src_srge->ternary_entries)
         {
-            for (const auto &dst_pat : gp.dst_srge.ternary_entries)
+            for (const auto &dst_pat : gp.dst_srge->ternary_entries)
             {
                 GrayTCAM_Entry entry;
                 entry.src_pattern = src_pat;
                 entry.dst_pattern = dst_pat;
                 entry.priority = gp.priority;
-                entry.action = gp.action;
+                entry.rid = gp.rid;
+                entry.action_id = gp.action_id;
                 tcam_entries.push_back(entry);
             }
         }
@@ -656,111 +747,114 @@ std::vector<GrayTCAM_Entry> generate_tcam_entries(const std::vector<GrayCodedPor
 // Module 7: Output Functions
 // ===============================================================================
 
-void print_tcam_rules(const std::vector<GrayTCAM_Entry> &tcam_entries,
-                      const std::vector<IPRule> &ip_table,
-                      const std::string &output_file)
+bool SRGETcamStream::open(const std::string &output_file)
 {
-    // Determine output stream
-    std::ostream *out_stream = &std::cout;
-    std::ofstream file_stream;
-
-    if (!output_file.empty())
+    total_ = 0;
+    if (!out_.open(output_file))
     {
-        // Create output directory if needed
-        size_t last_slash = output_file.find_last_of("/");
-        if (last_slash != std::string::npos)
-        {
-            std::string dir = output_file.substr(0, last_slash);
-            system(("mkdir -p " + dir).c_str());
-        }
+        return false;
+    }
 
-        file_stream.open(output_file);
-        if (!file_stream.is_open())
-        {
-            std::cerr << "[ERROR] Cannot open output file: " << output_file << "\n";
-            return;
-        }
-        out_stream = &file_stream;
+    out_.put_literal("=== TCAM Rules (Gray Code Ternary Format) ===\n\n");
+    return true;
+}
+
+void SRGETcamStream::write(const std::vector<GrayTCAM_Entry> &tcam_entries, const IPTable &ip_table,
+                           std::vector<RuleOutputSize> *per_rule)
+{
+    if (!out_.is_open())
+    {
+        return;
     }
 
-    *out_stream << "=== TCAM Rules (Gray Code Ternary Format) ===\n\n";
+    IPRuleIndex ip_index(ip_table);
 
     for (size_t i = 0; i < tcam_entries.size(); i++)
     {
         const auto &entry = tcam_entries[i];
+        uint64_t start = out_.offset();
 
-        // Find corresponding IP rule by priority
-        const IPRule *ip_rule = nullptr;
-        for (const auto &ipr : ip_table)
-        {
-            if (ipr.priority == entry.priority)
-            {
-                ip_rule = &ipr;
-                break;
-            }
-        }
-
-        if (!ip_rule)
+        // Find corresponding IP rule (rid, falling back to priority)
+        IPRule ip_rule;
+        if (!ip_index.find(entry.rid, entry.priority, ip_rule))
         {
             std::cerr << "[WARN] No IP rule found for priority " << entry.priority << "\n";
             continue;
         }
 
         // Format: @SRC_IP/MASK  DST_IP/MASK  SPORT_PATTERN  DPORT_PATTERN  PROTO/MASK  ACTION
-        *out_stream << "@";
-
-        // Source IP
-        uint32_t sip = ip_rule->src_ip_lo;
-        *out_stream << ((sip >> 24) & 0xFF) << "."
-                    << ((sip >> 16) & 0xFF) << "."
-                    << ((sip >> 8) & 0xFF) << "."
-                    << (sip & 0xFF) << "/" << ip_rule->src_prefix_len;
-
-        *out_stream << "     ";
-
-        // Destination IP
-        uint32_t dip = ip_rule->dst_ip_lo;
-        *out_stream << ((dip >> 24) & 0xFF) << "."
-                    << ((dip >> 16) & 0xFF) << "."
-                    << ((dip >> 8) & 0xFF) << "."
-                    << (dip & 0xFF) << "/" << ip_rule->dst_prefix_len;
-
-        *out_stream << "         ";
-
-        // Source port pattern (full 16-bit with leading zeros)
-        std::string src_full = entry.src_pattern;
-        // Pad to 16 bits if shorter
-        while (src_full.length() < 16)
-        {
-            src_full = "0" + src_full;
-        }
-        *out_stream << src_full << " ";
+        out_.put('@');
+        out_.put_ipv4(ip_rule.src_ip_lo);
+        out_.put('/');
+        out_.put_int(ip_rule.src_prefix_len);
+        out_.put_literal("     ");
+
+        out_.put_ipv4(ip_rule.dst_ip_lo);
+        out_.put('/');
+        out_.put_int(ip_rule.dst_prefix_len);
+        out_.put_literal("         ");
+
+        // Port patterns (full 16-bit, padded with leading zeros if shorter)
+        out_.put_pattern(entry.src_pattern, 16);
+        out_.put(' ');
+        out_.put_pattern(entry.dst_pattern, 16);
+        out_.put(' ');
 
-        // Destination port pattern (full 16-bit with leading zeros)
-        std::string dst_full = entry.dst_pattern;
-        // Pad to 16 bits if shorter
-        while (dst_full.length() < 16)
+        // Protocol
+        out_.put_literal("0x");
+        out_.put_hex2(ip_rule.proto);
+        out_.put_literal("/0xFF   ");
+
+        // Action
+        out_.put(ip_table.action(entry.action_id));
+        out_.put('\n');
+
+        if (per_rule)
         {
-            dst_full = "0" + dst_full;
+            RuleOutputSize &size = (*per_rule)[entry.rid];
+            size.bytes += (uint32_t)(out_.offset() - start);
+            size.entries++;
         }
-        *out_stream << dst_full << " ";
+    }
 
-        // Protocol
-        *out_stream << "0x" << std::hex << std::setw(2) << std::setfill('0')
-                    << (int)ip_rule->proto << "/0xFF   ";
+    total_ += tcam_entries.size();
+}
 
-        // Action
-        *out_stream << std::dec << entry.action;
+void SRGETcamStream::write_raw(const char *data, size_t n, uint64_t entries)
+{
+    if (!out_.is_open())
+    {
+        return;
+    }
+    out_.put(data, n);
+    total_ += entries;
+}
 
-        *out_stream << "\n";
+TcamWriteStats SRGETcamStream::close()
+{
+    if (!out_.is_open())
+    {
+        return TcamWriteStats();
     }
 
-    *out_stream << "\n=== Total TCAM Entries: " << tcam_entries.size() << " ===\n";
+    out_.put_literal("\n=== Total TCAM Entries: ");
+    out_.put_uint(total_);
+    out_.put_literal(" ===\n");
 
-    if (file_stream.is_open())
+    return out_.close();
+}
+
+TcamWriteStats print_tcam_rules(const std::vector<GrayTCAM_Entry> &tcam_entries,
+                                const IPTable &ip_table,
+                                const std::string &output_file)
+{
+    SRGETcamStream stream;
+    if (!stream.open(output_file))
     {
-        file_stream.close();
+        return TcamWriteStats();
     }
+    stream.write(tcam_entries, ip_table);
+    return stream.close();
 }
 
 // ============================================================
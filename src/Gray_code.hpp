@@ -7,17 +7,28 @@
 #include <set>
 
 #include "Loader.hpp"
+#include "Ternary.hpp"
+#include "Parallel.hpp"
+#include "RangeIntern.hpp"
+#include "TcamWriter.hpp"
+
+// ---------------Constants---------------------
+constexpr int GRAY_BITS = 16;  // Number of bits for port Gray codes
 
 // ---------------Struct Declarations---------------------
 
-// Ternary string representation: '0', '1', '*'
-using TernaryString = std::string;
+// Packed Gray-code ternary pattern ('0', '1', '*' as value/mask bits)
+using GrayPattern = Ternary<GRAY_BITS>;
 
 // Result of SRGE encoding for a single range
 struct SRGEResult {
-    std::vector<TernaryString> ternary_entries;  // Set of ternary strings covering the range
+    std::vector<GrayPattern> ternary_entries;    // Set of ternary patterns covering the range
+    uint32_t recursion_calls = 0;                // srge_recursive_impl invocations for this range
 };
 
+// Interned SRGE result: every rule with the same port range shares one encoding
+using SRGEHandle = RangeInternTable<SRGEResult>::Handle;
+
 struct GrayCodedPort
 {
     uint16_t src_port_lo;
@@ -32,24 +43,23 @@ struct GrayCodedPort
     uint16_t Src_LCA;               // least common ancestor position (bit index)
     uint16_t Dst_LCA;            // destination source range LCA position (bit index)
     uint32_t priority;          // Rule priority
-    std::string action;         // Action string
+    uint32_t rid = UINT32_MAX;  // RuleTable row (PortRule::rid)
+    uint16_t action_id = 0;     // RuleTable::actions index
     
-    // SRGE results for source and destination port ranges
-    SRGEResult src_srge;
-    SRGEResult dst_srge;
+    // SRGE results for source and destination port ranges (interned, shared across rules)
+    SRGEHandle src_srge;
+    SRGEHandle dst_srge;
 };
 
 struct GrayTCAM_Entry
 {
-    TernaryString src_pattern;  // Ternary pattern for source port
-    TernaryString dst_pattern;  // Ternary pattern for destination port
+    GrayPattern src_pattern;    // Ternary pattern for source port
+    GrayPattern dst_pattern;    // Ternary pattern for destination port
     uint32_t priority;
-    std::string action;
+    uint32_t rid = UINT32_MAX;  // RuleTable row, used by the writer's join
+    uint16_t action_id = 0;     // Text is looked up by the writer
 };
 
-// ---------------Constants---------------------
-constexpr int GRAY_BITS = 16;  // Number of bits for port Gray codes
-
 // ---------------Range Structure---------------------
 struct Range {
     uint16_t start;
@@ -76,7 +86,17 @@ SRGEResult srge_encode(uint16_t sb, uint16_t eb, int bits = GRAY_BITS);
 
 // Module 5: Port Table Processing
 // Convert port rules to Gray-coded entries and apply SRGE
-auto SRGE(const std::vector<PortRule> &port_table) -> std::vector<GrayCodedPort>;
+// threads: 1 = serial, 0 = all hardware threads; output order is the same either way
+auto SRGE(const PortTable &port_table, int threads = 1) -> std::vector<GrayCodedPort>;
+
+// Same, on the threads of a pool kept by the caller (e.g. across streaming batches)
+auto SRGE(const PortTable &port_table, ThreadPool &pool) -> std::vector<GrayCodedPort>;
+
+// Distinct ranges and hit rate of the SRGE range intern table
+RangeInternStats srge_intern_stats();
+
+// Drop all interned ranges and reset the stats (e.g. between streaming batches)
+void srge_intern_clear();
 
 // Module 6: TCAM Entry Generation
 // Generate expanded TCAM entries from Gray-coded ports
@@ -84,9 +104,30 @@ auto SRGE(const std::vector<PortRule> &port_table) -> std::vector<GrayCodedPort>
 std::vector<GrayTCAM_Entry> generate_tcam_entries(const std::vector<GrayCodedPort>& gray_ports);
 
 // Module 7: Output Functions
+// Streaming form of print_tcam_rules: the same file, written batch by batch.
+// Each write() joins its entries against the IP table of that batch;
+// per_rule (indexed by rid, pre-sized) accumulates the output of each rule.
+class SRGETcamStream
+{
+public:
+    bool open(const std::string &output_file);  // header; false if the file cannot be created
+    void write(const std::vector<GrayTCAM_Entry> &tcam_entries, const IPTable &ip_table,
+               std::vector<RuleOutputSize> *per_rule = nullptr);
+    // Already formatted entry lines (e.g. reused from an earlier file)
+    void write_raw(const char *data, size_t n, uint64_t entries);
+    TcamWriteStats close();                     // footer with the running total
+
+    uint64_t offset() const { return out_.offset(); }
+
+private:
+    TcamWriter out_;
+    uint64_t total_ = 0;
+};
+
 // Print TCAM entries in ternary rule format
 // If output_file is provided, writes to file; otherwise prints to stdout
-void print_tcam_rules(const std::vector<GrayTCAM_Entry>& tcam_entries, 
-                      const std::vector<IPRule>& ip_table,
-                      const std::string& output_file = "");
+// Returns bytes written and throughput (TcamWriter)
+TcamWriteStats print_tcam_rules(const std::vector<GrayTCAM_Entry>& tcam_entries, 
+                                const IPTable& ip_table,
+                                const std::string& output_file = "");
 
@@ -9,6 +9,8 @@
 #include <iostream>
 
 #include "Loader.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
 
 using namespace std;
 using u32 = uint32_t;
@@ -45,208 +47,641 @@ static std::pair<uint32_t,uint32_t> ip_range_from_parts(unsigned a, unsigned b,
 }
 
 
-void load_rules_from_file(const string &file, vector<Rule5D> &rules_out) {
-    FILE *fp = fopen(file.c_str(), "r");
-    if (!fp) {
-        fprintf(stderr, "error - cannot open rules file: %s\n", file.c_str());
-        exit(1);
+// ============================================================
+// Rule Line Tokenizer
+// ============================================================
+//
+// Grammar (one rule per line, fields separated by any run of spaces/tabs):
+//   @a.b.c.d/m  a.b.c.d/m  lo : hi  lo : hi  0xPP/0xMM  action
+// Same acceptance as the old sscanf("@%u.%u.%u.%u/%u %u.%u.%u.%u/%u %u : %u
+// %u : %u %x/%x %s") loop: '@' must open the line, '.' and '/' bind tightly,
+// whitespace around ':' is optional, the action (and anything after it) is
+// optional. Signed numbers are rejected instead of being wrapped.
+
+namespace {
+
+struct RuleLine {
+    unsigned sip[4], smask;
+    unsigned dip[4], dmask;
+    unsigned sport_lo, sport_hi;
+    unsigned dport_lo, dport_hi;
+    unsigned proto, proto_mask;
+    std::string_view action;  // view into the mapped file
+};
+
+inline bool is_space(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+}
+
+struct LineCursor {
+    const char *p;
+    const char *end;
+
+    void skip_space() {
+        while (p < end && is_space(*p)) ++p;
     }
 
-    unsigned sip1,sip2,sip3,sip4, smask;
-    unsigned dip1,dip2,dip3,dip4, dmask;
-    unsigned sport1, sport2, dport1, dport2;
-    unsigned protocol, protocol_mask;
-    unsigned action_flags, action_mask;
-    char action_str[64];  // 用于存储完整的 action 字符串
+    bool literal(char ch) {
+        if (p < end && *p == ch) { ++p; return true; }
+        return false;
+    }
 
-    u32 rule_count = 0;
-    u32 line_count = 0;
-    char buf[1024];
-    
-    // read lines until EOF using single buffered path
-    while (fgets(buf, sizeof(buf), fp)) {
-        line_count++;
-        
-        // Try multiple format patterns (spaces or tabs)
-        // 先尝试读取 action 为字符串格式
-        int ret = sscanf(buf, "@%u.%u.%u.%u/%u %u.%u.%u.%u/%u %u : %u %u : %u %x/%x %s",
-                         &sip1,&sip2,&sip3,&sip4,&smask,
-                         &dip1,&dip2,&dip3,&dip4,&dmask,
-                         &sport1,&sport2,&dport1,&dport2,
-                         &protocol,&protocol_mask,
-                         action_str);
-        
-        if (ret < 16) {
-            // Try tab-separated format
-            ret = sscanf(buf, "@%u.%u.%u.%u/%u\t%u.%u.%u.%u/%u\t%u : %u\t%u : %u\t%x/%x\t%s",
-                         &sip1,&sip2,&sip3,&sip4,&smask,
-                         &dip1,&dip2,&dip3,&dip4,&dmask,
-                         &sport1,&sport2,&dport1,&dport2,
-                         &protocol,&protocol_mask,
-                         action_str);
+    // %u: optional whitespace, optional '+', one or more decimal digits
+    bool dec(unsigned &out) {
+        skip_space();
+        if (p < end && *p == '+') ++p;
+        if (p >= end || (unsigned)(*p - '0') > 9) return false;
+        uint64_t v = 0;
+        while (p < end && (unsigned)(*p - '0') <= 9) {
+            v = v < (UINT64_MAX / 10) ? v * 10 + (uint64_t)(*p - '0') : UINT64_MAX;
+            ++p;
         }
-        
-        // 如果字符串格式失败，尝试旧的格式（兼容性）
-        if (ret < 16) {
-            ret = sscanf(buf, "@%u.%u.%u.%u/%u %u.%u.%u.%u/%u %u : %u %u : %u %x/%x %x/%x",
-                         &sip1,&sip2,&sip3,&sip4,&smask,
-                         &dip1,&dip2,&dip3,&dip4,&dmask,
-                         &sport1,&sport2,&dport1,&dport2,
-                         &protocol,&protocol_mask,
-                         &action_flags,&action_mask);
-            if (ret >= 17) {
-                // 从旧的格式构造 action 字符串
-                snprintf(action_str, sizeof(action_str), "0x%04X/0x%04X", action_flags, action_mask);
-            }
+        out = (unsigned)v;
+        return true;
+    }
+
+    // %x: optional whitespace, optional '+', optional 0x/0X, hex digits
+    // (a bare "0x" reads as 0 and consumes the 'x', as glibc does)
+    bool hex(unsigned &out) {
+        skip_space();
+        if (p < end && *p == '+') ++p;
+        if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            p += 2;
+        } else if (p >= end || hex_digit(*p) < 0) {
+            return false;
         }
-        
-        if (ret < 16) {
-            // skip invalid line
-            fprintf(stderr, "[WARN] Line %u: invalid format, skipping\n", line_count);
-            continue;
+        uint64_t v = 0;
+        for (int d; p < end && (d = hex_digit(*p)) >= 0; ++p) {
+            v = v <= (UINT64_MAX >> 4) ? (v << 4) | (uint64_t)d : UINT64_MAX;
         }
-        
-        // Validate IP octet ranges (must be 0-255)
-        if (sip1 > 255 || sip2 > 255 || sip3 > 255 || sip4 > 255 ||
-            dip1 > 255 || dip2 > 255 || dip3 > 255 || dip4 > 255) {
-            fprintf(stderr, "[WARN] Line %u: invalid IP octet (must be 0-255), skipping\n", line_count);
-            continue;
+        out = (unsigned)v;
+        return true;
+    }
+
+    // %s: optional whitespace, then the longest non-whitespace run (may be empty at EOL)
+    std::string_view word() {
+        skip_space();
+        const char *s = p;
+        while (p < end && !is_space(*p)) ++p;
+        return std::string_view(s, (size_t)(p - s));
+    }
+
+    static int hex_digit(char ch) {
+        if ((unsigned)(ch - '0') <= 9) return ch - '0';
+        if ((unsigned)((ch | 0x20) - 'a') <= 5) return (ch | 0x20) - 'a' + 10;
+        return -1;
+    }
+
+    bool ipv4_prefix(unsigned (&ip)[4], unsigned &mask) {
+        return dec(ip[0]) && literal('.') && dec(ip[1]) && literal('.') &&
+               dec(ip[2]) && literal('.') && dec(ip[3]) && literal('/') && dec(mask);
+    }
+
+    bool port_range(unsigned &lo, unsigned &hi) {
+        if (!dec(lo)) return false;
+        skip_space();
+        return literal(':') && dec(hi);
+    }
+};
+
+// Tokenize one line [p, end) without the trailing '\n'
+bool parse_rule_line(const char *p, const char *end, RuleLine &out) {
+    LineCursor cur{p, end};
+    if (!cur.literal('@')) return false;
+    if (!cur.ipv4_prefix(out.sip, out.smask)) return false;
+    if (!cur.ipv4_prefix(out.dip, out.dmask)) return false;
+    if (!cur.port_range(out.sport_lo, out.sport_hi)) return false;
+    if (!cur.port_range(out.dport_lo, out.dport_hi)) return false;
+    if (!cur.hex(out.proto) || !cur.literal('/') || !cur.hex(out.proto_mask)) return false;
+    out.action = cur.word();
+    return true;
+}
+
+// Reasons a line is skipped, in check order
+enum class LineError : uint8_t {
+    None,
+    Format,
+    IpOctet,
+    PortRange,
+    PortOrder,
+};
+
+void warn_line(LineError err, u32 line_no) {
+    switch (err) {
+    case LineError::Format:
+        fprintf(stderr, "[WARN] Line %u: invalid format, skipping\n", line_no);
+        break;
+    case LineError::IpOctet:
+        fprintf(stderr, "[WARN] Line %u: invalid IP octet (must be 0-255), skipping\n", line_no);
+        break;
+    case LineError::PortRange:
+        fprintf(stderr, "[WARN] Line %u: port out of range (must be 0-65535), skipping\n", line_no);
+        break;
+    case LineError::PortOrder:
+        fprintf(stderr, "[WARN] Line %u: invalid port range (lo > hi), skipping\n", line_no);
+        break;
+    case LineError::None:
+        break;
+    }
+}
+
+// Validate a tokenized line and build the rule (priority and action are filled by the caller)
+LineError rule_from_line(const RuleLine &ln, Rule5D &r) {
+    // Validate IP octet ranges (must be 0-255)
+    for (int i = 0; i < 4; ++i) {
+        if (ln.sip[i] > 255 || ln.dip[i] > 255) return LineError::IpOctet;
+    }
+
+    // Validate port ranges (must be 0-65535)
+    if (ln.sport_lo > 65535 || ln.sport_hi > 65535 || ln.dport_lo > 65535 || ln.dport_hi > 65535) {
+        return LineError::PortRange;
+    }
+
+    // Validate port ordering (lo should be <= hi)
+    if (ln.sport_lo > ln.sport_hi || ln.dport_lo > ln.dport_hi) {
+        return LineError::PortOrder;
+    }
+
+    // src IP
+    auto sr = ip_range_from_parts(ln.sip[0], ln.sip[1], ln.sip[2], ln.sip[3], ln.smask);
+    r.range[0][0] = sr.first;
+    r.range[0][1] = sr.second;
+    // dst IP
+    auto dr = ip_range_from_parts(ln.dip[0], ln.dip[1], ln.dip[2], ln.dip[3], ln.dmask);
+    r.range[1][0] = dr.first;
+    r.range[1][1] = dr.second;
+    // source port
+    r.range[2][0] = (u32)ln.sport_lo;
+    r.range[2][1] = (u32)ln.sport_hi;
+    // dest port
+    r.range[3][0] = (u32)ln.dport_lo;
+    r.range[3][1] = (u32)ln.dport_hi;
+    // protocol
+    if (ln.proto_mask == 0xFF) {
+        r.range[4][0] = (u32)ln.proto;
+        r.range[4][1] = (u32)ln.proto;
+    } else {
+        // mask 0x00 (wildcard) and any other mask: treat as full range
+        r.range[4][0] = 0u;
+        r.range[4][1] = 0xFFu;
+    }
+
+    // prefix_length fields: keep same semantics as original simple loader
+    r.prefix_length[0] = (int)ln.smask;
+    r.prefix_length[1] = (int)ln.dmask;
+    r.prefix_length[2] = (ln.sport_lo == ln.sport_hi) ? 0 : 1;
+    r.prefix_length[3] = (ln.dport_lo == ln.dport_hi) ? 0 : 1;
+    r.prefix_length[4] = (ln.proto_mask != 0x00) ? 0 : 1;
+
+    return LineError::None;
+}
+
+// ============================================================
+// Chunked Loading
+// ============================================================
+//
+// The mapping is cut into chunks that start right after a '\n'. Each chunk is
+// parsed independently with chunk-local line numbers; warnings are recorded,
+// not printed. The merge then walks the chunks in file order, prints the
+// warnings with global line numbers and assigns priorities 1..N over the
+// accepted rules, exactly as a single sequential pass would.
+
+struct LineWarning {
+    u32 line;  // line number within the chunk (1-based)
+    LineError err;
+};
+
+struct ChunkResult {
+    RuleTable rules;  // chunk-local action ids, priorities unset
+    vector<LineWarning> warnings;
+    u32 lines = 0;
+    std::exception_ptr error;  // thrown while parsing; stops the load at this chunk
+};
+
+void parse_chunk(const char *p, const char *end, ChunkResult &out) {
+    out.rules.reserve((size_t)(end - p) / 48);  // ~60 bytes per ClassBench line
+    RuleLine ln;
+    Rule5D r;
+
+    try {
+        while (p < end) {
+            const char *nl = static_cast<const char *>(memchr(p, '\n', (size_t)(end - p)));
+            const char *eol = nl ? nl : end;
+            out.lines++;
+
+            LineError err = parse_rule_line(p, eol, ln) ? rule_from_line(ln, r) : LineError::Format;
+            if (err == LineError::None) {
+                r.action_id = out.rules.intern_action(ln.action);  // 保存完整的 action 字符串格式
+                out.rules.push_back(r);
+            } else {
+                out.warnings.push_back({out.lines, err});
+            }
+
+            p = nl ? nl + 1 : end;
         }
-        
-        // Validate port ranges (must be 0-65535)
-        if (sport1 > 65535 || sport2 > 65535 || dport1 > 65535 || dport2 > 65535) {
-            fprintf(stderr, "[WARN] Line %u: port out of range (must be 0-65535), skipping\n", line_count);
-            continue;
+    } catch (...) {
+        out.error = std::current_exception();
+    }
+}
+
+// Chunk boundaries: ~equal byte ranges, each moved forward past the next '\n'
+vector<const char *> chunk_bounds(const char *begin, const char *end, size_t n_chunks) {
+    vector<const char *> bounds{begin};
+    size_t size = (size_t)(end - begin);
+    for (size_t i = 1; i < n_chunks; ++i) {
+        const char *cut = begin + size * i / n_chunks;
+        if (cut <= bounds.back()) continue;
+        const char *nl = static_cast<const char *>(memchr(cut - 1, '\n', (size_t)(end - cut + 1)));
+        if (!nl || nl + 1 >= end) break;
+        if (nl + 1 > bounds.back()) bounds.push_back(nl + 1);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Move a chunk's rows to the end of dst: action ids remapped to dst's table,
+// priorities continue from `priority`
+void append_chunk(RuleTable &dst, RuleTable &src, u32 &priority) {
+    if (dst.empty() && dst.actions.empty()) {  // first chunk: take the columns as they are
+        for (auto &p : src.priority) p = ++priority;
+        dst = std::move(src);
+        return;
+    }
+
+    vector<uint16_t> remap(src.actions.size());
+    for (size_t a = 0; a < src.actions.size(); ++a) remap[a] = dst.intern_action(src.actions[a]);
+
+    auto append = [](auto &to, const auto &from) { to.insert(to.end(), from.begin(), from.end()); };
+    append(dst.src_ip_lo, src.src_ip_lo);
+    append(dst.src_ip_hi, src.src_ip_hi);
+    append(dst.dst_ip_lo, src.dst_ip_lo);
+    append(dst.dst_ip_hi, src.dst_ip_hi);
+    append(dst.src_port_lo, src.src_port_lo);
+    append(dst.src_port_hi, src.src_port_hi);
+    append(dst.dst_port_lo, src.dst_port_lo);
+    append(dst.dst_port_hi, src.dst_port_hi);
+    append(dst.proto_lo, src.proto_lo);
+    append(dst.proto_hi, src.proto_hi);
+    for (int d = 0; d < 5; ++d) append(dst.prefix_length[d], src.prefix_length[d]);
+    for (size_t i = 0; i < src.size(); ++i) {
+        dst.priority.push_back(++priority);
+        dst.action_id.push_back(remap[src.action_id[i]]);
+    }
+}
+
+// Files below this size are parsed as one chunk on the calling thread
+constexpr size_t PARALLEL_LOAD_MIN_CHUNK = 1 << 20;
+
+} // namespace
+
+bool parse_rule_text(std::string_view line, uint32_t line_no, Rule5D &r, std::string_view &action) {
+    RuleLine ln;
+    const char *p = line.data();
+    LineError err = parse_rule_line(p, p + line.size(), ln) ? rule_from_line(ln, r) : LineError::Format;
+    if (err != LineError::None) {
+        warn_line(err, line_no);
+        return false;
+    }
+    action = ln.action;
+    return true;
+}
+
+void load_rules_from_file(const string &file, RuleTable &rules_out, int threads) {
+    MappedFile mf;
+    if (!mf.open(file)) {
+        fprintf(stderr, "error - cannot open rules file: %s\n", file.c_str());
+        exit(1);
+    }
+
+    const char *begin = mf.data();
+    const char *end = begin + mf.size();
+
+    threads = resolve_thread_count(threads);
+    size_t n_chunks = 1;
+    if (threads > 1) {
+        n_chunks = std::min((size_t)threads * 4, mf.size() / PARALLEL_LOAD_MIN_CHUNK);
+        n_chunks = std::max<size_t>(n_chunks, 1);
+    }
+
+    vector<const char *> bounds = chunk_bounds(begin, end, n_chunks);
+    vector<ChunkResult> chunks(bounds.size() - 1);
+    parallel_for_each_index(chunks.size(), threads, [&](size_t i) {
+        parse_chunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // Merge in file order: global line numbers for warnings, sequential priorities
+    size_t total = rules_out.size();
+    for (const auto &c : chunks) total += c.rules.size();
+
+    u32 line_base = 0;
+    u32 rule_count = 0;
+    for (auto &c : chunks) {
+        for (const auto &w : c.warnings) {
+            warn_line(w.err, line_base + w.line);
         }
-        
-        // Validate port ordering (lo should be <= hi)
-        if (sport1 > sport2 || dport1 > dport2) {
-            fprintf(stderr, "[WARN] Line %u: invalid port range (lo > hi), skipping\n", line_count);
-            continue;
+        append_chunk(rules_out, c.rules, rule_count);
+        rules_out.reserve(total);  // after the first chunk, which may be moved in
+        c.rules.clear();  // release the chunk as soon as it is merged
+        if (c.error) {
+            std::rethrow_exception(c.error);
         }
+        line_base += c.lines;
+    }
+}
 
-        Rule5D r;
-        // src IP
-        auto sr = ip_range_from_parts(sip1,sip2,sip3,sip4, smask);
-        r.range[0][0] = sr.first;
-        r.range[0][1] = sr.second;
-        // dst IP
-        auto dr = ip_range_from_parts(dip1,dip2,dip3,dip4, dmask);
-        r.range[1][0] = dr.first;
-        r.range[1][1] = dr.second;
-        // source port
-        r.range[2][0] = (u32)sport1;
-        r.range[2][1] = (u32)sport2;
-        // dest port
-        r.range[3][0] = (u32)dport1;
-        r.range[3][1] = (u32)dport2;
-        // protocol
-        if (protocol_mask == 0xFF) {
-            r.range[4][0] = (u32)protocol;
-            r.range[4][1] = (u32)protocol;
-        } else if (protocol_mask == 0x00) {
-            r.range[4][0] = 0u;
-            r.range[4][1] = 0xFFu;
+size_t stream_rules_from_file(const string &file, size_t batch_size,
+                              const std::function<void(const RuleTable &)> &on_batch) {
+    MappedFile mf;
+    if (!mf.open(file)) {
+        fprintf(stderr, "error - cannot open rules file: %s\n", file.c_str());
+        exit(1);
+    }
+    batch_size = std::max<size_t>(batch_size, 1);
+
+    RuleTable batch;
+    batch.reserve(batch_size);
+    RuleLine ln;
+    Rule5D r;
+    u32 line_no = 0;
+    u32 rule_count = 0;
+
+    const char *p = mf.data();
+    const char *end = p + mf.size();
+    while (p < end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', (size_t)(end - p)));
+        const char *eol = nl ? nl : end;
+        line_no++;
+
+        LineError err = parse_rule_line(p, eol, ln) ? rule_from_line(ln, r) : LineError::Format;
+        if (err == LineError::None) {
+            r.priority = ++rule_count;
+            r.action_id = batch.intern_action(ln.action);
+            batch.push_back(r);
         } else {
-            // if other masks appear, for now treat as full range (or you can refine)
-            r.range[4][0] = 0u;
-            r.range[4][1] = 0xFFu;
+            warn_line(err, line_no);
+        }
+        p = nl ? nl + 1 : end;
+
+        if (batch.size() == batch_size) {
+            on_batch(batch);
+            batch.clear_rows();
+            mf.release_before(p);  // parsed text is not needed again
         }
+    }
+    if (!batch.empty()) {
+        on_batch(batch);
+    }
+    return rule_count;
+}
+
+// ============================================================
+// RuleTable
+// ============================================================
+
+void RuleTable::clear() {
+    *this = RuleTable();
+}
+
+void RuleTable::clear_rows() {
+    for (auto *col : {&src_ip_lo, &src_ip_hi, &dst_ip_lo, &dst_ip_hi, &priority}) col->clear();
+    for (auto *col : {&src_port_lo, &src_port_hi, &dst_port_lo, &dst_port_hi, &action_id}) col->clear();
+    for (auto *col : {&proto_lo, &proto_hi}) col->clear();
+    for (auto &col : prefix_length) col.clear();
+}
+
+void RuleTable::reserve(size_t n) {
+    src_ip_lo.reserve(n);
+    src_ip_hi.reserve(n);
+    dst_ip_lo.reserve(n);
+    dst_ip_hi.reserve(n);
+    src_port_lo.reserve(n);
+    src_port_hi.reserve(n);
+    dst_port_lo.reserve(n);
+    dst_port_hi.reserve(n);
+    proto_lo.reserve(n);
+    proto_hi.reserve(n);
+    for (auto &col : prefix_length) col.reserve(n);
+    priority.reserve(n);
+    action_id.reserve(n);
+}
+
+uint16_t RuleTable::intern_action(std::string_view action) {
+    // Consecutive rules almost always share the action
+    if (!actions.empty() && actions.back() == action) {
+        return (uint16_t)(actions.size() - 1);
+    }
+    auto it = action_index_.find(string(action));
+    if (it != action_index_.end()) return it->second;
+
+    if (actions.size() > UINT16_MAX) {
+        throw std::length_error("more than 65536 distinct actions");
+    }
+    uint16_t id = (uint16_t)actions.size();
+    actions.emplace_back(action);
+    action_index_.emplace(actions.back(), id);
+    return id;
+}
+
+void RuleTable::push_back(const Rule5D &r) {
+    src_ip_lo.push_back(r.range[0][0]);
+    src_ip_hi.push_back(r.range[0][1]);
+    dst_ip_lo.push_back(r.range[1][0]);
+    dst_ip_hi.push_back(r.range[1][1]);
+    src_port_lo.push_back(static_cast<uint16_t>(r.range[2][0]));
+    src_port_hi.push_back(static_cast<uint16_t>(r.range[2][1]));
+    dst_port_lo.push_back(static_cast<uint16_t>(r.range[3][0]));
+    dst_port_hi.push_back(static_cast<uint16_t>(r.range[3][1]));
+    proto_lo.push_back(static_cast<uint8_t>(r.range[4][0]));
+    proto_hi.push_back(static_cast<uint8_t>(r.range[4][1]));
+    for (int d = 0; d < 5; ++d) prefix_length[d].push_back(static_cast<uint8_t>(r.prefix_length[d]));
+    priority.push_back(r.priority);
+    action_id.push_back(r.action_id);
+}
 
-        // prefix_length fields: keep same semantics as original simple loader
-        r.prefix_length[0] = (int)smask;
-        r.prefix_length[1] = (int)dmask;
-        r.prefix_length[2] = (sport1 == sport2) ? 0 : 1;
-        r.prefix_length[3] = (dport1 == dport2) ? 0 : 1;
-        r.prefix_length[4] = (protocol_mask != 0x00) ? 0 : 1;
+RuleColumns RuleTable::columns() const {
+    RuleColumns c;
+    c.rows = size();
+    c.src_ip_lo = src_ip_lo.data();
+    c.src_ip_hi = src_ip_hi.data();
+    c.dst_ip_lo = dst_ip_lo.data();
+    c.dst_ip_hi = dst_ip_hi.data();
+    c.src_port_lo = src_port_lo.data();
+    c.src_port_hi = src_port_hi.data();
+    c.dst_port_lo = dst_port_lo.data();
+    c.dst_port_hi = dst_port_hi.data();
+    c.proto_lo = proto_lo.data();
+    c.proto_hi = proto_hi.data();
+    for (int d = 0; d < 5; ++d) c.prefix_length[d] = prefix_length[d].data();
+    c.priority = priority.data();
+    c.action_id = action_id.data();
+    c.actions = &actions;
+    return c;
+}
+
+// ============================================================
+// IP Tuple Merge
+// ============================================================
+
+namespace {
 
-        ++rule_count;
-        r.priority = rule_count;
-        r.action = std::string(action_str);  // 保存完整的 action 字符串格式
+struct IPTupleKey {
+    uint32_t src_lo, src_hi, dst_lo, dst_hi;
+    uint8_t proto_lo, proto_hi, src_len, dst_len;
+
+    bool operator==(const IPTupleKey &o) const {
+        return src_lo == o.src_lo && src_hi == o.src_hi && dst_lo == o.dst_lo && dst_hi == o.dst_hi &&
+               proto_lo == o.proto_lo && proto_hi == o.proto_hi && src_len == o.src_len && dst_len == o.dst_len;
+    }
+};
 
-        rules_out.emplace_back(r);
+struct IPTupleHash {
+    size_t operator()(const IPTupleKey &k) const {
+        uint64_t a = ((uint64_t)k.src_lo << 32) | k.dst_lo;
+        uint64_t b = ((uint64_t)k.src_hi << 32) | k.dst_hi;
+        uint64_t c = ((uint64_t)k.proto_lo << 24) | ((uint64_t)k.proto_hi << 16) |
+                     ((uint64_t)k.src_len << 8) | k.dst_len;
+        uint64_t h = a * 0x9E3779B97F4A7C15ULL;
+        h ^= (b + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2));
+        h ^= (c + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2));
+        return (size_t)(h ^ (h >> 29));
     }
+};
 
-    fclose(fp);
+} // namespace
+
+IPTable::IPTable(const RuleColumns &t) : rules_(t) {
+    const uint32_t n = (uint32_t)t.size();
+    tuple_of_.resize(n);
+
+    unordered_map<IPTupleKey, uint32_t, IPTupleHash> ids;
+    ids.reserve(n);
+    vector<uint32_t> members(1, 0);  // members per tuple, then prefix sums
+    for (uint32_t r = 0; r < n; ++r) {
+        IPTupleKey key{t.src_ip_lo[r], t.src_ip_hi[r], t.dst_ip_lo[r], t.dst_ip_hi[r],
+                       t.proto_lo[r], t.proto_hi[r], t.prefix_length[0][r], t.prefix_length[1][r]};
+        auto ins = ids.emplace(key, (uint32_t)rmax_id_.size());
+        uint32_t id = ins.first->second;
+        if (ins.second) {
+            rmax_id_.push_back(r);
+            members.push_back(0);
+        } else if (t.priority[r] < t.priority[rmax_id_[id]]) {
+            rmax_id_[id] = r;  // smaller value = higher priority
+        }
+        tuple_of_[r] = id;
+        members[id + 1]++;
+    }
+
+    // Group member rids by tuple (counting sort keeps them ascending)
+    for (size_t i = 1; i < members.size(); ++i) members[i] += members[i - 1];
+    merged_offs_ = members;
+    merged_rids_.resize(n);
+    for (uint32_t r = 0; r < n; ++r) {
+        merged_rids_[members[tuple_of_[r]]++] = r;
+    }
+
+    cols_.tuples = rmax_id_.size();
+    cols_.rmax_id = rmax_id_.data();
+    cols_.merged_offs = merged_offs_.data();
+    cols_.merged_rids = merged_rids_.data();
+    cols_.tuple_of = tuple_of_.data();
 }
 
 void split_rules(
-    const std::vector<Rule5D>& all_rules,
-    std::vector<IPRule>& ip_table,
-    std::vector<PortRule>& port_table
+    const RuleColumns& all_rules,
+    IPTable& ip_table,
+    PortTable& port_table
 ) {
-    ip_table.clear();
-    port_table.clear();
-    uint32_t i=0;
-
-    for (const auto& r : all_rules) {
-        // ----  IP part ----
-        IPRule ipr;
-        ipr.src_ip_lo = r.range[0][0];
-        ipr.src_ip_hi = r.range[0][1];
-        ipr.dst_ip_lo = r.range[1][0];
-        ipr.dst_ip_hi = r.range[1][1];
-        ipr.proto     = static_cast<uint8_t>(r.range[4][0]);
-        ipr.priority  = r.priority;
-        ipr.src_prefix_len = r.prefix_length[0];  // mask length
-        ipr.dst_prefix_len = r.prefix_length[1];
-
-        ip_table.push_back(ipr);
-
-        // ----  Port part ----
-        PortRule pr;
-        pr.rid         = i;
-        pr.src_port_lo = static_cast<uint16_t>(r.range[2][0]);
-        pr.src_port_hi = static_cast<uint16_t>(r.range[2][1]);
-        pr.dst_port_lo = static_cast<uint16_t>(r.range[3][0]);
-        pr.dst_port_hi = static_cast<uint16_t>(r.range[3][1]);
-        pr.priority    = r.priority;
-        pr.action      = r.action;  // 保存完整的 action 字符串格式
-        port_table.push_back(pr);
-
-        i++; 
-    }
+    ip_table = IPTable(all_rules);
+    port_table = PortTable(all_rules, 0, (uint32_t)all_rules.size());
 
     std::cout << "[split_rules] IP table size = " << ip_table.size()
+              << " (" << all_rules.size() << " rules merged)"
               << ", Port table size = " << port_table.size() << std::endl;
 }
 
-static string ip_to_string(uint32_t ip) {
-    return to_string((ip >> 24) & 0xFF) + "." +
-           to_string((ip >> 16) & 0xFF) + "." +
-           to_string((ip >> 8) & 0xFF) + "." +
-           to_string(ip & 0xFF);
-           
+bool IPRuleIndex::find(uint32_t rid, uint32_t priority, IPRule& out) const {
+    if (rid < table_.rule_count() && table_.rule_priority(rid) == priority) {
+        if (rid != last_rid_) {
+            last_ = table_[table_.tuple_of(rid)];
+            last_rid_ = rid;
+        }
+        out = last_;
+        return true;
+    }
+
+    if (!indexed_) {
+        by_priority_.reserve(table_.rule_count());
+        for (uint32_t r = 0; r < table_.rule_count(); ++r) {
+            by_priority_.emplace(table_.rule_priority(r), r);  // emplace keeps the first
+        }
+        indexed_ = true;
+    }
+
+    auto it = by_priority_.find(priority);
+    if (it == by_priority_.end()) return false;
+    out = table_[table_.tuple_of(it->second)];
+    return true;
+}
+
+// ============================================================
+// Range to CIDR
+// ============================================================
+
+size_t range_to_cidr(uint32_t start, uint32_t end, CidrPrefix *out) {
+    size_t n = 0;
+    uint64_t cur = start;
+    const uint64_t last = end;
+    while (cur <= last) {
+        // Largest block that is aligned at cur and fits in the remaining range
+        uint64_t remaining = last - cur + 1;                         // 1 .. 2^32
+        int align = cur ? __builtin_ctz((uint32_t)cur) : 32;
+        int fit = 63 - __builtin_clzll(remaining);                   // floor(log2(remaining))
+        int host_bits = align < fit ? align : fit;
+
+        out[n++] = CidrPrefix{(uint32_t)cur, (uint8_t)(32 - host_bits)};
+        cur += 1ULL << host_bits;
+    }
+    return n;
+}
+
+void range_to_cidr_batch(const uint32_t *lo, const uint32_t *hi, size_t count,
+                         vector<CidrPrefix> &prefixes, vector<uint32_t> &offsets) {
+    prefixes.clear();
+    offsets.assign(1, 0);
+    offsets.reserve(count + 1);
+    prefixes.reserve(count);  // rule IPs are mostly single prefixes
+
+    CidrPrefix buf[MAX_CIDR_PER_RANGE];
+    for (size_t i = 0; i < count; ++i) {
+        size_t n = range_to_cidr(lo[i], hi[i], buf);
+        prefixes.insert(prefixes.end(), buf, buf + n);
+        offsets.push_back((uint32_t)prefixes.size());
+    }
+}
+
+size_t format_cidr(const CidrPrefix &p, char *buf) {
+    char *out = buf;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        unsigned octet = (p.addr >> shift) & 0xFF;
+        if (octet >= 100) *out++ = (char)('0' + octet / 100);
+        if (octet >= 10) *out++ = (char)('0' + octet / 10 % 10);
+        *out++ = (char)('0' + octet % 10);
+        *out++ = shift ? '.' : '/';
+    }
+    if (p.len >= 10) *out++ = (char)('0' + p.len / 10);
+    *out++ = (char)('0' + p.len % 10);
+    return (size_t)(out - buf);
 }
 
 vector<string> range_to_cidr(uint32_t start, uint32_t end) {
+    CidrPrefix prefixes[MAX_CIDR_PER_RANGE];
+    size_t n = range_to_cidr(start, end, prefixes);
+
     vector<string> res;
-    while (start <= end) {
-        uint32_t max_size = start & -start; 
-        uint64_t remaining = (uint64_t)end - (uint64_t)start + 1;
-
-        int prefix = 32;
-        while (max_size > 1) {
-            max_size >>= 1;
-            prefix--;
-        }
-        // prefix < 0 
-        while (prefix > 0 && (1ULL << (32 - prefix)) > remaining) {
-            prefix++;
-        }
-        
-        // prefix !> 32
-        if (prefix > 32) prefix = 32;
-
-        res.push_back(ip_to_string(start) + "/" + to_string(prefix));
-        
-        // 64-bit for step calculation 
-        uint64_t step = (prefix == 0) ? (1ULL << 32) : (1ULL << (32 - prefix));
-        uint64_t next = (uint64_t)start + step;
-        
-        // check overflow
-        if (next > 0xFFFFFFFFULL) break;
-        start = (uint32_t)next;
+    res.reserve(n);
+    char buf[CIDR_TEXT_MAX];
+    for (size_t i = 0; i < n; ++i) {
+        res.emplace_back(buf, format_cidr(prefixes[i], buf));
     }
     return res;
 }
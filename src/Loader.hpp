@@ -1,8 +1,11 @@
 #pragma once
 #include <array>
+#include <functional>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
 #include <iostream>
 
 // ---------------Struct Declarations---------------------
@@ -12,18 +15,91 @@ struct Rule5D {
     std::array<std::array<uint32_t,2>, 5> range; 
     std::array<int,5> prefix_length;  // store prefix-like info (as in original)
     uint32_t priority;
-    std::string action;  // 保存完整的 action 格式，如 "0x0000/0x0200" 或 "0x1000/0x1000"
+    uint16_t action_id;  // RuleTable::actions 下标，完整格式如 "0x0000/0x0200" 或 "0x1000/0x1000"
+};
+
+// ---------------Rule Columns---------------------
+// Read-only column pointers of a rule table, row index = rid. Comes from a
+// RuleTable (RuleTable::columns) or straight from the mapped columns of a
+// rule snapshot (RuleSnapshot::columns), so tables built on top of it never
+// need the rows copied. The source must outlive the view.
+struct RuleColumns {
+    size_t rows = 0;
+    const uint32_t *src_ip_lo = nullptr, *src_ip_hi = nullptr;
+    const uint32_t *dst_ip_lo = nullptr, *dst_ip_hi = nullptr;
+    const uint16_t *src_port_lo = nullptr, *src_port_hi = nullptr;
+    const uint16_t *dst_port_lo = nullptr, *dst_port_hi = nullptr;
+    const uint8_t  *proto_lo = nullptr, *proto_hi = nullptr;
+    std::array<const uint8_t*, 5> prefix_length{};
+    const uint32_t *priority = nullptr;
+    const uint16_t *action_id = nullptr;
+    const std::vector<std::string> *actions = nullptr;  // indexed by action_id
+
+    size_t size() const { return rows; }
+    bool empty() const { return rows == 0; }
+};
+
+// ---------------Rule Table---------------------
+// All loaded rules in columnar (SoA) form; row index = rid, rows in file order.
+// Actions are interned: action_id indexes the actions table.
+struct RuleTable {
+    std::vector<uint32_t> src_ip_lo, src_ip_hi;
+    std::vector<uint32_t> dst_ip_lo, dst_ip_hi;
+    std::vector<uint16_t> src_port_lo, src_port_hi;
+    std::vector<uint16_t> dst_port_lo, dst_port_hi;
+    std::vector<uint8_t>  proto_lo, proto_hi;
+    std::array<std::vector<uint8_t>, 5> prefix_length;  // Rule5D::prefix_length
+    std::vector<uint32_t> priority;
+    std::vector<uint16_t> action_id;
+    std::vector<std::string> actions;  // 完整的 action 字符串，按首次出现顺序
+
+    size_t size() const { return priority.size(); }
+    bool empty() const { return priority.empty(); }
+
+    void clear();
+    void clear_rows();  // keeps the action table (and ids) and the capacity
+    void reserve(size_t n);
+
+    // ID of an action string, added on first use; throws std::length_error past 65536
+    uint16_t intern_action(std::string_view action);
+
+    // r.action_id must come from intern_action() of this table
+    void push_back(const Rule5D& r);
+
+    // Read-only view of the columns; invalidated by any modification
+    RuleColumns columns() const;
+
+private:
+    std::unordered_map<std::string, uint16_t> action_index_;
+};
+
+// ---------------Table Views---------------------
+// split_rules no longer copies rules. PortTable is an index span [begin, end)
+// over rule columns; IPTable holds the distinct IP tuples of the rules and
+// refers back to their rows. The columns' source (RuleTable or snapshot) must
+// outlive both. Rows are assembled from the columns on access; encoders read
+// the port columns directly.
+
+// Rule indices (rids) of one merged IP tuple, ascending
+struct RuleIndexSpan {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return (size_t)(last - first); }
 };
 
 struct IPRule {
     uint32_t src_ip_lo, src_ip_hi;
     uint32_t dst_ip_lo, dst_ip_hi;
-    uint8_t  proto;
-    uint32_t priority;
+    uint8_t  proto;     // proto_lo
+    uint8_t  proto_hi;  // proto .. proto_hi; 0 .. 255 is a wildcard
+    uint32_t priority;  // priority of rmax_id
     int src_prefix_len;
     int dst_prefix_len;
-    std::vector<size_t> merged_R;  // original rule indices
-    size_t rmax_id; // 添加Rmax ID字段
+    RuleIndexSpan merged_R;  // original rule indices
+    uint32_t rmax_id;        // 优先级最高的成员 (smallest priority value)
 };
 
 struct PortRule {
@@ -31,19 +107,179 @@ struct PortRule {
     uint16_t src_port_lo, src_port_hi;
     uint16_t dst_port_lo, dst_port_hi;
     uint32_t priority;
-    std::string action;  // 保存完整的 action 格式，如 "0x0000/0x0200" 或 "0x1000/0x1000"
+    uint16_t action_id;
+};
+
+// Columns of an IPTable (saved in rule snapshots and used from the mapping)
+struct IPTupleColumns {
+    size_t tuples = 0;
+    const uint32_t* rmax_id = nullptr;      // per tuple
+    const uint32_t* merged_offs = nullptr;  // per tuple + 1, into merged_rids
+    const uint32_t* merged_rids = nullptr;  // per rule: members grouped by tuple
+    const uint32_t* tuple_of = nullptr;     // per rule
+};
+
+// Distinct (src prefix, dst prefix, proto) tuples of a rule set, in order of
+// first appearance. Rules sharing a tuple are merged into one IP entry.
+class IPTable {
+public:
+    IPTable() = default;
+    explicit IPTable(const RuleTable& table) : IPTable(table.columns()) {}
+    explicit IPTable(const RuleColumns& rules);  // hash merge, O(n)
+
+    // Over precomputed tuple columns (e.g. a snapshot): no merge, no copy
+    IPTable(const RuleColumns& rules, const IPTupleColumns& tuples) : rules_(rules), cols_(tuples) {}
+
+    // Move-only: cols_ may point into the owned vectors
+    IPTable(IPTable&&) = default;
+    IPTable& operator=(IPTable&&) = default;
+    IPTable(const IPTable&) = delete;
+    IPTable& operator=(const IPTable&) = delete;
+
+    // Number of distinct IP tuples
+    size_t size() const { return cols_.tuples; }
+    bool empty() const { return cols_.tuples == 0; }
+
+    IPRule operator[](size_t i) const {
+        const RuleColumns& t = rules_;
+        uint32_t r = cols_.rmax_id[i];
+        return IPRule{t.src_ip_lo[r], t.src_ip_hi[r], t.dst_ip_lo[r], t.dst_ip_hi[r],
+                      t.proto_lo[r], t.proto_hi[r], t.priority[r],
+                      t.prefix_length[0][r], t.prefix_length[1][r],
+                      RuleIndexSpan{cols_.merged_rids + cols_.merged_offs[i],
+                                    cols_.merged_rids + cols_.merged_offs[i + 1]},
+                      r};
+    }
+
+    // Per original rule: its tuple and its own priority
+    size_t rule_count() const { return rules_.rows; }
+    uint32_t tuple_of(uint32_t rid) const { return cols_.tuple_of[rid]; }
+    uint32_t rule_priority(uint32_t rid) const { return rules_.priority[rid]; }
+
+    // Action text of an id carried by port / TCAM entries (writers only)
+    const std::string& action(uint16_t id) const { return (*rules_.actions)[id]; }
+
+    const IPTupleColumns& columns() const { return cols_; }
+
+private:
+    RuleColumns rules_;
+    IPTupleColumns cols_;
+    // Storage of a merged table (empty when cols_ points into a snapshot)
+    std::vector<uint32_t> rmax_id_;
+    std::vector<uint32_t> merged_offs_;
+    std::vector<uint32_t> merged_rids_;
+    std::vector<uint32_t> tuple_of_;
+};
+
+class PortTable {
+public:
+    PortTable() = default;
+    PortTable(const RuleTable& table, uint32_t begin, uint32_t end)
+        : PortTable(table.columns(), begin, end) {}
+    PortTable(const RuleColumns& rules, uint32_t begin, uint32_t end)
+        : rules_(rules), begin_(begin), end_(end) {}
+
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return end_ == begin_; }
+
+    PortRule operator[](size_t i) const {
+        const RuleColumns& t = rules_;
+        size_t r = begin_ + i;
+        return PortRule{(uint32_t)r, t.src_port_lo[r], t.src_port_hi[r],
+                        t.dst_port_lo[r], t.dst_port_hi[r], t.priority[r], t.action_id[r]};
+    }
+
+    // Contiguous columns; element i belongs to row i of the span
+    uint32_t rid(size_t i) const { return begin_ + (uint32_t)i; }
+    const uint16_t* src_port_lo() const { return rules_.src_port_lo + begin_; }
+    const uint16_t* src_port_hi() const { return rules_.src_port_hi + begin_; }
+    const uint16_t* dst_port_lo() const { return rules_.dst_port_lo + begin_; }
+    const uint16_t* dst_port_hi() const { return rules_.dst_port_hi + begin_; }
+    const uint32_t* priority() const { return rules_.priority + begin_; }
+    const uint16_t* action_id() const { return rules_.action_id + begin_; }
+
+private:
+    RuleColumns rules_;
+    uint32_t begin_ = 0, end_ = 0;
+};
+
+// ---------------IP Rule Join---------------------
+// TCAM writers resolve each entry to its IP tuple in O(1): the entry's rid
+// (a RuleTable row) is mapped through the tuple column after checking the
+// priority; entries that do not line up fall back to a priority index,
+// built once on the first miss.
+class IPRuleIndex {
+public:
+    explicit IPRuleIndex(const IPTable& ip_table) : table_(ip_table) {}
+
+    // false if no rule has this priority
+    bool find(uint32_t rid, uint32_t priority, IPRule& out) const;
+
+private:
+    const IPTable& table_;
+    mutable uint32_t last_rid_ = UINT32_MAX;  // expanded entries of a rule arrive together
+    mutable IPRule last_{};
+    mutable std::unordered_map<uint32_t, uint32_t> by_priority_; // first rule per priority
+    mutable bool indexed_ = false;
 };
 
 // ---------------Function Declarations---------------------
+// threads: 1 = sequential, 0 = all hardware threads. Priorities and warning
+// line numbers are identical for every thread count.
 void load_rules_from_file(
     const std::string &file,
-    std::vector<Rule5D> &rules_out
+    RuleTable &rules_out,
+    int threads = 1
+);
+
+// One rule line (without '\n') with the loader's grammar and checks. On
+// rejection prints the loader's [WARN] for line_no and returns false.
+// priority and action_id are left to the caller; action views into line.
+bool parse_rule_text(std::string_view line, uint32_t line_no, Rule5D &r, std::string_view &action);
+
+// Streaming load for bounded memory: rules are handed to on_batch in batches
+// of at most batch_size rows, with the same priorities and warnings as
+// load_rules_from_file. The batch table is reused: its rows are cleared after
+// each call while the action table is kept, so action ids stay valid across
+// batches. Returns the number of rules loaded.
+size_t stream_rules_from_file(
+    const std::string &file,
+    size_t batch_size,
+    const std::function<void(const RuleTable &batch)> &on_batch
 );
 
+// Merge rules into distinct IP tuples; the port table spans every row
 void split_rules(
-    const std::vector<Rule5D>& all_rules,
-    std::vector<IPRule>& ip_table,
-    std::vector<PortRule>& port_table
+    const RuleColumns& all_rules,
+    IPTable& ip_table,
+    PortTable& port_table
 );
 
+inline void split_rules(const RuleTable& all_rules, IPTable& ip_table, PortTable& port_table) {
+    split_rules(all_rules.columns(), ip_table, port_table);
+}
+
+// ---------------Range to CIDR---------------------
+// Minimal CIDR cover of an IP range as packed (addr, len) pairs; strings are
+// only produced by format_cidr at output time.
+struct CidrPrefix {
+    uint32_t addr;
+    uint8_t  len;
+};
+
+constexpr size_t MAX_CIDR_PER_RANGE = 62;  // worst case, e.g. [1, 0xFFFFFFFE]
+constexpr size_t CIDR_TEXT_MAX = 19;       // "255.255.255.255/32" + 1
+
+// Writes up to MAX_CIDR_PER_RANGE prefixes to out; returns the count (0 if start > end)
+size_t range_to_cidr(uint32_t start, uint32_t end, CidrPrefix *out);
+
+// Expand count ranges (e.g. a RuleTable IP column pair). Prefixes of range i
+// are prefixes[offsets[i] .. offsets[i + 1]).
+void range_to_cidr_batch(const uint32_t *lo, const uint32_t *hi, size_t count,
+                         std::vector<CidrPrefix> &prefixes,
+                         std::vector<uint32_t> &offsets);
+
+// "a.b.c.d/len" into buf (at least CIDR_TEXT_MAX - 1 bytes, not terminated); returns the length
+size_t format_cidr(const CidrPrefix &p, char *buf);
+
 std::vector<std::string> range_to_cidr(uint32_t start, uint32_t end);
\ No newline at end of file
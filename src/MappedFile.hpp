@@ -0,0 +1,118 @@
+/** *************************************************************/
+// @Name: MappedFile.hpp
+// @Function: Read-only memory mapping of an input file
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-27
+// @Description: mmap(2) with a read(2) fallback for files that cannot be mapped
+/************************************************************* */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Contents stay valid for the lifetime of the object; string_views into
+// data() must not outlive it.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // false if the file cannot be opened or read
+    bool open(const std::string &path)
+    {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            size_ = (size_t)st.st_size;
+            if (size_ == 0) // mmap rejects empty mappings
+            {
+                ::close(fd);
+                return true;
+            }
+
+            void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                madvise(p, size_, MADV_SEQUENTIAL);
+                map_ = p;
+                data_ = static_cast<const char *>(p);
+                ::close(fd);
+                return true;
+            }
+        }
+
+        // Pipes, character devices or failed mmap: read everything
+        bool ok = read_all(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    void close()
+    {
+        if (map_)
+            munmap(map_, size_);
+        map_ = nullptr;
+        data_ = nullptr;
+        size_ = 0;
+        fallback_.clear();
+        fallback_.shrink_to_fit();
+    }
+
+    // Drop the resident pages before p (sequential readers that are done with
+    // them); the bytes stay readable. No-op for the read() fallback.
+    void release_before(const char *p)
+    {
+        if (!map_ || p <= data_)
+            return;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t len = (size_t)(p - data_) / page * page;
+        if (len)
+            madvise(map_, len, MADV_DONTNEED);
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_ ? data_ : "", size_); }
+
+private:
+    bool read_all(int fd)
+    {
+        fallback_.clear();
+        char chunk[1 << 16];
+        for (;;)
+        {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0)
+                return false;
+            if (n == 0)
+                break;
+            fallback_.insert(fallback_.end(), chunk, chunk + n);
+        }
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        return true;
+    }
+
+    void *map_ = nullptr;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> fallback_;
+};
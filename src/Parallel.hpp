@@ -0,0 +1,213 @@
+/** *************************************************************/
+// @Name: Parallel.hpp
+// @Function: Fixed-size thread pool with chunked parallel_for
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-25
+// @Description: Used by SRGE / DIRPE / CGFE port-table encoding (--threads N)
+/************************************************************* */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Resolve a --threads value: 0 = one per hardware thread, otherwise at least 1
+inline int resolve_thread_count(int threads)
+{
+    if (threads <= 0)
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        return hw ? (int)hw : 1;
+    }
+    return threads;
+}
+
+// ===============================================================================
+// ThreadPool
+// ===============================================================================
+//
+// parallel_for(n, chunk, fn) splits [0, n) into chunks of `chunk` indices and
+// calls fn(begin, end) once per chunk. Workers (and the calling thread) pull
+// chunks from a shared atomic counter, so uneven rules balance out. Callers
+// write results into pre-sized slots by index, which keeps input order.
+// The first exception thrown by fn stops further chunks and is rethrown to the
+// caller of parallel_for.
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads)
+    {
+        int n = resolve_thread_count(threads);
+        for (int i = 1; i < n; ++i) // The calling thread is worker 0
+            workers_.emplace_back([this]
+                                  { worker_loop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &t : workers_)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return (int)workers_.size() + 1; }
+
+    // Blocks until every chunk has run
+    void parallel_for(size_t n, size_t chunk, const std::function<void(size_t, size_t)> &fn)
+    {
+        if (n == 0)
+            return;
+        chunk = std::max<size_t>(chunk, 1);
+
+        if (workers_.empty() || n <= chunk)
+        {
+            fn(0, n);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &fn;
+            job_n_ = n;
+            job_chunk_ = chunk;
+            next_.store(0);
+            active_ = (int)workers_.size();
+            generation_++;
+        }
+        wake_.notify_all();
+
+        run_chunks(fn, n, chunk);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]
+                   { return active_ == 0; });
+        job_ = nullptr;
+
+        if (error_)
+        {
+            std::exception_ptr e = error_;
+            error_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    // Chunk size giving each thread several chunks to balance uneven work
+    size_t chunk_for(size_t n, size_t min_chunk = 64) const
+    {
+        return std::max(min_chunk, n / ((size_t)size() * 8) + 1);
+    }
+
+private:
+    void run_chunks(const std::function<void(size_t, size_t)> &fn, size_t n, size_t chunk)
+    {
+        for (;;)
+        {
+            size_t begin = next_.fetch_add(chunk);
+            if (begin >= n)
+                break;
+            try
+            {
+                fn(begin, std::min(n, begin + chunk));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_)
+                    error_ = std::current_exception();
+                next_.store(n); // Skip the remaining chunks
+            }
+        }
+    }
+
+    void worker_loop()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            const std::function<void(size_t, size_t)> *fn;
+            size_t n, chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&]
+                           { return stop_ || generation_ != seen; });
+                if (stop_)
+                    return;
+                seen = generation_;
+                fn = job_;
+                n = job_n_;
+                chunk = job_chunk_;
+            }
+
+            run_chunks(*fn, n, chunk);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--active_ == 0)
+                    done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const std::function<void(size_t, size_t)> *job_ = nullptr;
+    size_t job_n_ = 0;
+    size_t job_chunk_ = 1;
+    std::atomic<size_t> next_{0};
+    int active_ = 0;
+    std::exception_ptr error_;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+// Run body(i) for every i in [0, n) on the threads of pool
+template <class Body>
+inline void parallel_for_each_index(size_t n, ThreadPool &pool, Body &&body)
+{
+    if (pool.size() <= 1)
+    {
+        for (size_t i = 0; i < n; ++i)
+            body(i);
+        return;
+    }
+
+    pool.parallel_for(n, pool.chunk_for(n), [&body](size_t begin, size_t end)
+                      {
+        for (size_t i = begin; i < end; ++i)
+            body(i); });
+}
+
+// Run body(i) for every i in [0, n) on `threads` threads (1 = serial, no pool).
+// Starts a pool per call: callers that run repeatedly should keep one pool.
+template <class Body>
+inline void parallel_for_each_index(size_t n, int threads, Body &&body)
+{
+    if (resolve_thread_count(threads) <= 1)
+    {
+        for (size_t i = 0; i < n; ++i)
+            body(i);
+        return;
+    }
+
+    ThreadPool pool(threads);
+    parallel_for_each_index(n, pool, body);
+}
@@ -0,0 +1,223 @@
+/** *************************************************************/
+// @Name: RangeIntern.hpp
+// @Function: Intern table for encoded port ranges shared across rules
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-24
+// @Description: (params, lo, hi) -> immutable encoding, one table per encoder
+/************************************************************* */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// ===============================================================================
+// Intern Statistics
+// ===============================================================================
+
+struct RangeInternStats
+{
+    uint64_t lookups = 0; // Ranges requested by the encoders
+    uint64_t hits = 0;    // Requests served by an already-encoded range
+    size_t distinct = 0;  // Distinct (params, lo, hi) keys encoded
+
+    double hit_rate() const { return lookups ? (double)hits / lookups : 0.0; }
+};
+
+// ===============================================================================
+// RangeInternTable<Result>
+// ===============================================================================
+//
+// Real ACLs reuse a handful of port ranges (0:65535, 1024:65535, single
+// ports), so each encoder keeps one table mapping its parameters and the range
+// to a shared, immutable Result. Ports hold RangeInternTable::Handle instead of
+// owning their own pattern vectors.
+//
+// intern() is thread-safe without a lock on the hit path: every thread has a
+// front cache per table that only it touches, and falls back to the shared
+// table (under a mutex) on a miss. A range enters a front cache on its second
+// use, when the shared table already has it, as a per-thread alias of the
+// shared handle (its own control block, which keeps the shared one alive), so
+// copying a common range does not bounce one reference count between cores. If two threads race on a new key, the first insert wins and
+// the loser's result is dropped (counted as a hit), so
+// lookups == hits + distinct regardless of thread count.
+
+template <class Result>
+class RangeInternTable
+{
+public:
+    using Handle = std::shared_ptr<const Result>;
+
+    RangeInternTable() : shared_(std::make_shared<Shared>()) {}
+    RangeInternTable(const RangeInternTable &) = delete;
+    RangeInternTable &operator=(const RangeInternTable &) = delete;
+
+    // params: encoder parameters packed into 32 bits (e.g. bit width, W, c)
+    template <class Encode>
+    Handle intern(uint32_t params, uint16_t lo, uint16_t hi, Encode &&encode)
+    {
+        uint64_t key = ((uint64_t)params << 32) | ((uint64_t)lo << 16) | hi;
+
+        FrontCache &front = front_cache();
+        front.sync(shared_->generation.load(std::memory_order_acquire));
+        bump(front.lookups);
+        auto it = front.table.find(key);
+        if (it != front.table.end())
+        {
+            bump(front.hits);
+            return it->second;
+        }
+
+        bool inserted = false;
+        Handle h = shared_intern(key, lo, hi, encode, inserted);
+        if (inserted)
+            return h; // First use: most ranges never repeat, keep them out of the front cache
+        Handle local(std::make_shared<Handle>(h), h.get());
+        front.table.emplace(key, local);
+        return local;
+    }
+
+    RangeInternStats stats() const
+    {
+        Shared &sh = *shared_;
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        RangeInternStats s;
+        s.lookups = sh.retired_lookups;
+        s.hits = sh.retired_hits + sh.shared_hits;
+        for (const FrontCache *f : sh.live)
+        {
+            s.lookups += f->lookups.load(std::memory_order_relaxed) - f->base_lookups;
+            s.hits += f->hits.load(std::memory_order_relaxed) - f->base_hits;
+        }
+        s.distinct = sh.table.size();
+        return s;
+    }
+
+    // Handles already given out stay valid; only the tables forget them.
+    // Front caches drop their entries on their thread's next intern().
+    void clear()
+    {
+        Shared &sh = *shared_;
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        sh.table.clear();
+        sh.shared_hits = 0;
+        sh.retired_lookups = sh.retired_hits = 0;
+        for (FrontCache *f : sh.live)
+        {
+            f->base_lookups = f->lookups.load(std::memory_order_relaxed);
+            f->base_hits = f->hits.load(std::memory_order_relaxed);
+        }
+        sh.generation.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    struct FrontCache;
+
+    // State shared by all threads; mutex guards everything but generation.
+    // Front caches hold it too, so a thread may outlive its table.
+    struct Shared
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Handle> table;
+        uint64_t shared_hits = 0;                       // Front misses served by the table
+        uint64_t retired_lookups = 0, retired_hits = 0; // Counters of exited threads since clear()
+        std::vector<FrontCache *> live;
+        std::atomic<uint64_t> generation{0};            // Bumped by clear()
+    };
+
+    // Table and counters are written only by the owning thread
+    struct FrontCache
+    {
+        std::shared_ptr<Shared> owner;
+        std::unordered_map<uint64_t, Handle> table;
+        uint64_t generation = 0;
+        std::atomic<uint64_t> lookups{0}, hits{0};
+        uint64_t base_lookups = 0, base_hits = 0; // Counters at the last clear(), under owner->mutex
+
+        explicit FrontCache(std::shared_ptr<Shared> sh) : owner(std::move(sh))
+        {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            generation = owner->generation.load(std::memory_order_relaxed);
+            owner->live.push_back(this);
+        }
+
+        ~FrontCache()
+        {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            owner->retired_lookups += lookups.load(std::memory_order_relaxed) - base_lookups;
+            owner->retired_hits += hits.load(std::memory_order_relaxed) - base_hits;
+            owner->live.erase(std::find(owner->live.begin(), owner->live.end(), this));
+        }
+
+        // Drop entries interned before the last clear()
+        void sync(uint64_t current)
+        {
+            if (generation == current)
+                return;
+            table.clear();
+            generation = current;
+        }
+    };
+
+    // Single writer: a plain load / store instead of a locked add
+    static void bump(std::atomic<uint64_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    FrontCache &front_cache()
+    {
+        // Plain pointers: no thread_local init / destructor guard on the hit path
+        thread_local const Shared *last_owner = nullptr;
+        thread_local FrontCache *last = nullptr;
+        if (last_owner == shared_.get())
+            return *last;
+        last = &front_cache_slow();
+        last_owner = shared_.get();
+        return *last;
+    }
+
+    FrontCache &front_cache_slow()
+    {
+        // One front cache per table this thread used (one table per encoder)
+        thread_local std::vector<std::unique_ptr<FrontCache>> fronts;
+        for (auto &f : fronts)
+        {
+            if (f->owner == shared_)
+                return *f;
+        }
+        fronts.push_back(std::make_unique<FrontCache>(shared_));
+        return *fronts.back();
+    }
+
+    template <class Encode>
+    Handle shared_intern(uint64_t key, uint16_t lo, uint16_t hi, Encode &encode, bool &inserted)
+    {
+        Shared &sh = *shared_;
+        {
+            std::lock_guard<std::mutex> lock(sh.mutex);
+            auto it = sh.table.find(key);
+            if (it != sh.table.end())
+            {
+                sh.shared_hits++;
+                return it->second;
+            }
+        }
+
+        Handle h = std::make_shared<const Result>(encode(lo, hi));
+
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        auto ins = sh.table.emplace(key, h);
+        inserted = ins.second;
+        if (!inserted)
+            sh.shared_hits++;
+        return ins.first->second;
+    }
+
+    std::shared_ptr<Shared> shared_;
+};
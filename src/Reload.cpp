@@ -0,0 +1,611 @@
+/** *************************************************************/
+// @Name: Reload.cpp
+// @Function: Incremental rebuild of the TCAM rule files after a rule-file edit
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-02
+/************************************************************* */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <sys/stat.h>
+
+#include "Reload.hpp"
+#include "Chunk_code.hpp"
+#include "Gray_code.hpp"
+#include "Loader.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+// Every TCAM entry line depends only on the text of its rule line (the
+// priority is not printed), so the output of a rule file is a header, the
+// output of each line in order, and a footer. The state file records, per
+// line, a content hash and the byte / entry count it contributed to each
+// output. A reload diffs the line hashes, copies the byte spans of unchanged
+// lines from the old files and encodes the rest.
+
+// ===============================================================================
+// Module 1: Line Hashing
+// ===============================================================================
+
+namespace {
+
+constexpr uint32_t NO_LINE = UINT32_MAX;
+
+struct LineRef
+{
+    uint64_t offset; // into the rules file
+    uint32_t len;    // without '\n'
+};
+
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Stable 64-bit content hash (same value in every run of every build)
+uint64_t hash_line(const char *p, size_t n)
+{
+    uint64_t h = mix64(0x9E3779B97F4A7C15ULL ^ n);
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t k;
+        memcpy(&k, p, 8);
+        h = mix64(h ^ k) + 0x632BE59BD9B4E019ULL;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, n);
+    return mix64(h ^ tail);
+}
+
+// Same line split as the loader: '\n' terminated, last line may lack it
+void split_lines(const MappedFile &src, vector<LineRef> &lines, vector<uint64_t> &hashes)
+{
+    const char *begin = src.data();
+    const char *p = begin;
+    const char *end = begin + src.size();
+    while (p < end)
+    {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', (size_t)(end - p)));
+        const char *eol = nl ? nl : end;
+        lines.push_back(LineRef{(uint64_t)(p - begin), (uint32_t)(eol - p)});
+        hashes.push_back(hash_line(p, (size_t)(eol - p)));
+        p = nl ? nl + 1 : end;
+    }
+}
+
+// ===============================================================================
+// Module 2: State File
+// ===============================================================================
+//
+//   ReloadStateHeader
+//   uint64_t hash[line_count]
+//   uint32_t bytes[RELOAD_OUTPUTS][line_count]
+//   uint32_t entries[RELOAD_OUTPUTS][line_count]
+//   uint8_t  accepted[line_count]
+
+constexpr char RELOAD_STATE_MAGIC[8] = {'T', 'C', 'A', 'M', 'S', 'T', 'A', 'T'};
+constexpr uint32_t RELOAD_STATE_VERSION = 1;
+
+struct ReloadStateHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_width;
+    uint32_t cgfe_W, cgfe_c;
+    uint64_t line_count;
+    uint64_t header_bytes[RELOAD_OUTPUTS]; // Bytes before the first entry line
+    uint64_t file_size[RELOAD_OUTPUTS];    // Outputs as written by that build
+    int64_t file_mtime_ns[RELOAD_OUTPUTS];
+};
+
+// Per-line records of one build
+struct LineTable
+{
+    vector<uint64_t> hash;
+    vector<uint32_t> bytes[RELOAD_OUTPUTS];
+    vector<uint32_t> entries[RELOAD_OUTPUTS];
+    vector<uint8_t> accepted;
+    uint64_t header_bytes[RELOAD_OUTPUTS] = {};
+};
+
+// The previous build, mapped read-only
+struct OldBuild
+{
+    MappedFile state;
+    MappedFile output[RELOAD_OUTPUTS];
+    size_t lines = 0;
+    const uint64_t *hash = nullptr;
+    const uint32_t *bytes[RELOAD_OUTPUTS] = {};
+    const uint32_t *entries[RELOAD_OUTPUTS] = {};
+    const uint8_t *accepted = nullptr;
+    vector<uint64_t> offset[RELOAD_OUTPUTS]; // Start of each line's output, lines + 1
+};
+
+bool stat_file(const string &path, uint64_t &size, int64_t &mtime_ns)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    size = (uint64_t)st.st_size;
+    mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// False (full rebuild) unless the state matches cfg and the outputs are untouched
+bool load_old_build(const ReloadConfig &cfg, OldBuild &old)
+{
+    if (!old.state.open(cfg.state_file) || old.state.size() < sizeof(ReloadStateHeader))
+        return false;
+
+    const ReloadStateHeader *hdr = reinterpret_cast<const ReloadStateHeader *>(old.state.data());
+    if (memcmp(hdr->magic, RELOAD_STATE_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != RELOAD_STATE_VERSION ||
+        hdr->chunk_width != (uint32_t)cfg.chunk_width || hdr->cgfe_W != (uint32_t)cfg.cgfe.W ||
+        hdr->cgfe_c != (uint32_t)cfg.cgfe.c)
+    {
+        return false;
+    }
+
+    const uint64_t n = hdr->line_count;
+    const uint64_t per_line = 8 + RELOAD_OUTPUTS * 8 + 1;
+    if (n > old.state.size() || old.state.size() != sizeof(ReloadStateHeader) + n * per_line)
+        return false;
+
+    const char *p = old.state.data() + sizeof(ReloadStateHeader);
+    old.lines = (size_t)n;
+    old.hash = reinterpret_cast<const uint64_t *>(p);
+    p += n * 8;
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o, p += n * 4)
+        old.bytes[o] = reinterpret_cast<const uint32_t *>(p);
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o, p += n * 4)
+        old.entries[o] = reinterpret_cast<const uint32_t *>(p);
+    old.accepted = reinterpret_cast<const uint8_t *>(p);
+
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+    {
+        uint64_t size;
+        int64_t mtime;
+        if (!stat_file(cfg.output_file[o], size, mtime) || size != hdr->file_size[o] ||
+            mtime != hdr->file_mtime_ns[o] || !old.output[o].open(cfg.output_file[o]) ||
+            old.output[o].size() != size)
+        {
+            return false;
+        }
+
+        vector<uint64_t> &off = old.offset[o];
+        off.resize(old.lines + 1);
+        off[0] = hdr->header_bytes[o];
+        for (size_t j = 0; j < old.lines; ++j)
+            off[j + 1] = off[j] + old.bytes[o][j];
+        if (off[old.lines] > size)
+            return false;
+    }
+    return true;
+}
+
+bool save_state(const ReloadConfig &cfg, const LineTable &lines)
+{
+    ReloadStateHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RELOAD_STATE_MAGIC, sizeof(hdr.magic));
+    hdr.version = RELOAD_STATE_VERSION;
+    hdr.chunk_width = (uint32_t)cfg.chunk_width;
+    hdr.cgfe_W = (uint32_t)cfg.cgfe.W;
+    hdr.cgfe_c = (uint32_t)cfg.cgfe.c;
+    hdr.line_count = lines.hash.size();
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+    {
+        hdr.header_bytes[o] = lines.header_bytes[o];
+        if (!stat_file(cfg.output_file[o], hdr.file_size[o], hdr.file_mtime_ns[o]))
+            return false;
+    }
+
+    // Write to a temporary file, then rename: a torn state is never picked up
+    string tmp = cfg.state_file + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (!fp)
+        return false;
+    auto put = [&](const auto &v) {
+        return v.empty() || fwrite(v.data(), sizeof(v[0]), v.size(), fp) == v.size();
+    };
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 && put(lines.hash);
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+        ok = ok && put(lines.bytes[o]);
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+        ok = ok && put(lines.entries[o]);
+    ok = ok && put(lines.accepted);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), cfg.state_file.c_str()) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ===============================================================================
+// Module 3: Line Diff
+// ===============================================================================
+
+// Greedy fallback for a range without anchors: each new line takes the next
+// unused old line with the same hash after the last match.
+void match_greedy(const uint64_t *old_hash, size_t olo, size_t ohi,
+                  const vector<uint64_t> &new_hash, size_t nlo, size_t nhi, vector<uint32_t> &old_of_new)
+{
+    struct Occurrences
+    {
+        vector<uint32_t> pos;
+        size_t next = 0;
+    };
+    unordered_map<uint64_t, Occurrences> occurrences;
+    for (size_t j = olo; j < ohi; ++j)
+        occurrences[old_hash[j]].pos.push_back((uint32_t)j);
+
+    int64_t last = (int64_t)olo - 1;
+    for (size_t i = nlo; i < nhi; ++i)
+    {
+        auto it = occurrences.find(new_hash[i]);
+        if (it == occurrences.end())
+            continue;
+        Occurrences &occ = it->second;
+        while (occ.next < occ.pos.size() && (int64_t)occ.pos[occ.next] <= last)
+            occ.next++;
+        if (occ.next < occ.pos.size())
+        {
+            old_of_new[i] = occ.pos[occ.next++];
+            last = old_of_new[i];
+        }
+    }
+}
+
+// Patience diff of old[olo, ohi) against new[nlo, nhi): common prefix/suffix,
+// then lines unique on both sides whose old positions form the longest
+// increasing run become anchors, and the gaps between anchors recurse.
+void match_range(const uint64_t *old_hash, size_t olo, size_t ohi,
+                 const vector<uint64_t> &new_hash, size_t nlo, size_t nhi, vector<uint32_t> &old_of_new)
+{
+    while (olo < ohi && nlo < nhi && old_hash[olo] == new_hash[nlo])
+        old_of_new[nlo++] = (uint32_t)olo++;
+    while (olo < ohi && nlo < nhi && old_hash[ohi - 1] == new_hash[nhi - 1])
+        old_of_new[--nhi] = (uint32_t)--ohi;
+    if (olo == ohi || nlo == nhi)
+        return;
+
+    struct Count
+    {
+        uint32_t in_old = 0, in_new = 0, old_pos = 0;
+    };
+    unordered_map<uint64_t, Count> counts;
+    counts.reserve(ohi - olo);
+    for (size_t j = olo; j < ohi; ++j)
+    {
+        Count &c = counts[old_hash[j]];
+        c.in_old++;
+        c.old_pos = (uint32_t)j;
+    }
+    for (size_t i = nlo; i < nhi; ++i)
+    {
+        auto it = counts.find(new_hash[i]);
+        if (it != counts.end())
+            it->second.in_new++;
+    }
+
+    // Candidate anchors in new order: (new line, old line)
+    vector<std::pair<uint32_t, uint32_t>> cand;
+    for (size_t i = nlo; i < nhi; ++i)
+    {
+        auto it = counts.find(new_hash[i]);
+        if (it != counts.end() && it->second.in_old == 1 && it->second.in_new == 1)
+            cand.push_back({(uint32_t)i, it->second.old_pos});
+    }
+    if (cand.empty())
+    {
+        match_greedy(old_hash, olo, ohi, new_hash, nlo, nhi, old_of_new);
+        return;
+    }
+
+    // Longest increasing subsequence of old positions (patience sorting)
+    vector<uint32_t> pile_top; // index into cand of the smallest tail per length
+    vector<int32_t> prev(cand.size(), -1);
+    for (size_t k = 0; k < cand.size(); ++k)
+    {
+        auto pos = std::lower_bound(pile_top.begin(), pile_top.end(), cand[k].second,
+                                    [&](uint32_t t, uint32_t v) { return cand[t].second < v; });
+        if (pos != pile_top.begin())
+            prev[k] = (int32_t)*(pos - 1);
+        if (pos == pile_top.end())
+            pile_top.push_back((uint32_t)k);
+        else
+            *pos = (uint32_t)k;
+    }
+    vector<uint32_t> anchors;
+    for (int32_t k = (int32_t)pile_top.back(); k >= 0; k = prev[k])
+        anchors.push_back((uint32_t)k);
+    std::reverse(anchors.begin(), anchors.end());
+
+    size_t o = olo, n = nlo;
+    for (uint32_t k : anchors)
+    {
+        match_range(old_hash, o, cand[k].second, new_hash, n, cand[k].first, old_of_new);
+        old_of_new[cand[k].first] = cand[k].second;
+        o = cand[k].second + 1;
+        n = cand[k].first + 1;
+    }
+    match_range(old_hash, o, ohi, new_hash, n, nhi, old_of_new);
+}
+
+// old_of_new[i]: old line matched to new line i (strictly increasing), or NO_LINE.
+vector<uint32_t> match_lines(const uint64_t *old_hash, size_t n_old, const vector<uint64_t> &new_hash)
+{
+    vector<uint32_t> old_of_new(new_hash.size(), NO_LINE);
+    match_range(old_hash, 0, n_old, new_hash, 0, new_hash.size(), old_of_new);
+    return old_of_new;
+}
+
+// ===============================================================================
+// Module 4: Output Splicing
+// ===============================================================================
+
+// What every output shares: the diff and the freshly encoded rules
+struct SpliceInput
+{
+    const vector<uint32_t> &old_of_new;
+    const vector<uint32_t> &fresh_rid; // per new line, row in the fresh RuleTable or NO_LINE
+    const IPTable &ip_table;
+    size_t fresh_rules;
+    const OldBuild &old;
+};
+
+// "<prefix><line>" for every entry line in [p, p + n)
+void put_prefixed_lines(TcamWriter &out, const char *prefix, const char *p, size_t n)
+{
+    const char *end = p + n;
+    while (p < end)
+    {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', (size_t)(end - p)));
+        const char *next = nl ? nl + 1 : end;
+        out.put(prefix, 2);
+        out.put(p, (size_t)(next - p));
+        p = next;
+    }
+}
+
+// Write output o: reused spans copied from the old file, fresh rules written
+// through the stream (already open on a temporary path). Fills the per-line
+// records of o, writes the delta and renames the file into place.
+template <class Stream, class Entry>
+bool splice_output(int o, const string &output_file, Stream &stream, const string &tmp_file,
+                   const vector<Entry> &entries, const SpliceInput &in, LineTable &lines, ReloadStats &st)
+{
+    const size_t n = in.old_of_new.size();
+    const OldBuild &old = in.old;
+    lines.header_bytes[o] = stream.offset();
+    lines.bytes[o].assign(n, 0);
+    lines.entries[o].assign(n, 0);
+
+    // First entry of each fresh rule (entries are rule-major, rid ascending)
+    vector<size_t> first(in.fresh_rules + 1, entries.size());
+    for (size_t e = entries.size(); e-- > 0;)
+        first[entries[e].rid] = e;
+    for (size_t r = in.fresh_rules; r-- > 0;)
+        first[r] = min(first[r], first[r + 1]);
+
+    vector<RuleOutputSize> per_rule(in.fresh_rules);
+    for (size_t i = 0; i < n;)
+    {
+        size_t k = i + 1;
+        if (in.old_of_new[i] != NO_LINE)
+        {
+            // Old lines that stay adjacent form one span of the old file
+            uint32_t j = in.old_of_new[i];
+            while (k < n && in.old_of_new[k] == j + (k - i))
+                k++;
+            uint64_t entry_count = 0;
+            for (size_t m = i; m < k; ++m)
+            {
+                lines.bytes[o][m] = old.bytes[o][j + (m - i)];
+                lines.entries[o][m] = old.entries[o][j + (m - i)];
+                entry_count += lines.entries[o][m];
+            }
+            const uint64_t from = old.offset[o][j], to = old.offset[o][j + (k - i)];
+            stream.write_raw(old.output[o].data() + from, (size_t)(to - from), entry_count);
+        }
+        else
+        {
+            while (k < n && in.old_of_new[k] == NO_LINE)
+                k++;
+            // Accepted lines of the run are consecutive fresh rows
+            size_t r0 = in.fresh_rules, r1 = 0;
+            for (size_t m = i; m < k; ++m)
+            {
+                if (in.fresh_rid[m] != NO_LINE)
+                {
+                    r0 = min<size_t>(r0, in.fresh_rid[m]);
+                    r1 = max<size_t>(r1, in.fresh_rid[m] + 1);
+                }
+            }
+            if (r0 < r1)
+            {
+                vector<Entry> run(entries.begin() + first[r0], entries.begin() + first[r1]);
+                stream.write(run, in.ip_table, &per_rule);
+            }
+            for (size_t m = i; m < k; ++m)
+            {
+                if (in.fresh_rid[m] != NO_LINE)
+                {
+                    lines.bytes[o][m] = per_rule[in.fresh_rid[m]].bytes;
+                    lines.entries[o][m] = per_rule[in.fresh_rid[m]].entries;
+                }
+            }
+        }
+        i = k;
+    }
+    st.write[o] = stream.close();
+    for (size_t i = 0; i < n; ++i)
+        st.entries[o] += lines.entries[o][i];
+    if (!st.write[o].ok)
+    {
+        remove(tmp_file.c_str());
+        return false;
+    }
+
+    // Delta: removed entries of the old file, then added entries of the new one
+    MappedFile fresh_file;
+    if (!fresh_file.open(tmp_file))
+        return false;
+    vector<uint8_t> kept(old.lines, 0);
+    for (uint32_t j : in.old_of_new)
+        if (j != NO_LINE)
+            kept[j] = 1;
+    for (size_t j = 0; j < old.lines; ++j)
+        if (!kept[j])
+            st.dropped[o] += old.entries[o][j];
+    for (size_t i = 0; i < n; ++i)
+        if (in.old_of_new[i] == NO_LINE)
+            st.added[o] += lines.entries[o][i];
+
+    TcamWriter delta;
+    if (!delta.open(delta_path_for(output_file)))
+        return false;
+    delta.put_literal("# Delta of ");
+    delta.put(output_file);
+    delta.put_literal(": -");
+    delta.put_uint(st.dropped[o]);
+    delta.put_literal(" +");
+    delta.put_uint(st.added[o]);
+    delta.put_literal(" entries\n");
+    for (size_t j = 0; j < old.lines; ++j)
+    {
+        if (!kept[j])
+            put_prefixed_lines(delta, "- ", old.output[o].data() + old.offset[o][j], old.bytes[o][j]);
+    }
+    uint64_t offset = lines.header_bytes[o];
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (in.old_of_new[i] == NO_LINE)
+            put_prefixed_lines(delta, "+ ", fresh_file.data() + offset, lines.bytes[o][i]);
+        offset += lines.bytes[o][i];
+    }
+    if (!delta.close().ok)
+        return false;
+
+    // The old file stays mapped (and readable) after being replaced
+    if (rename(tmp_file.c_str(), output_file.c_str()) != 0)
+    {
+        fprintf(stderr, "[ERROR] Cannot replace %s\n", output_file.c_str());
+        remove(tmp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ===============================================================================
+// Module 5: Reload
+// ===============================================================================
+
+string delta_path_for(const string &output_file)
+{
+    size_t dot = output_file.find_last_of('.');
+    size_t slash = output_file.find_last_of('/');
+    if (dot == string::npos || (slash != string::npos && dot < slash))
+        return output_file + ".delta";
+    return output_file.substr(0, dot) + ".delta";
+}
+
+bool reload_tcam_outputs(const string &rules_path, const ReloadConfig &cfg, ReloadStats &st)
+{
+    st = ReloadStats();
+    MappedFile src;
+    if (!src.open(rules_path))
+    {
+        fprintf(stderr, "error - cannot open rules file: %s\n", rules_path.c_str());
+        return false;
+    }
+
+    // Step 1: hash the new lines and match them against the previous build
+    vector<LineRef> refs;
+    LineTable lines;
+    split_lines(src, refs, lines.hash);
+    const size_t n = refs.size();
+    st.lines = n;
+
+    OldBuild old;
+    st.incremental = load_old_build(cfg, old);
+    if (!st.incremental)
+        old.lines = 0;
+    vector<uint32_t> old_of_new = match_lines(old.hash, old.lines, lines.hash);
+
+    // Step 2: parse only unmatched lines, into a RuleTable of their own
+    RuleTable fresh;
+    vector<uint32_t> fresh_rid(n, NO_LINE);
+    lines.accepted.assign(n, 0);
+    uint32_t priority = 0;
+    Rule5D r;
+    string_view action;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (old_of_new[i] != NO_LINE)
+        {
+            lines.accepted[i] = old.accepted[old_of_new[i]];
+            priority += lines.accepted[i];
+            st.reused++;
+            continue;
+        }
+        st.encoded++;
+        string_view text(src.data() + refs[i].offset, refs[i].len);
+        if (parse_rule_text(text, (uint32_t)(i + 1), r, action))
+        {
+            r.priority = ++priority;
+            r.action_id = fresh.intern_action(action);
+            fresh_rid[i] = (uint32_t)fresh.size();
+            fresh.push_back(r);
+            lines.accepted[i] = 1;
+        }
+    }
+    st.removed = old.lines - st.reused;
+
+    // Step 3: encode and expand the fresh rules
+    IPTable ip_table(fresh);
+    PortTable port_table(fresh, 0, (uint32_t)fresh.size());
+    ThreadPool own_pool(cfg.pool ? 1 : cfg.threads);
+    ThreadPool &pool = cfg.pool ? *cfg.pool : own_pool;
+    auto srge_tcam = generate_tcam_entries(SRGE(port_table, pool));
+    auto dirpe_tcam = generate_dirpe_tcam_entries(DIRPE(port_table, cfg.chunk_width, pool));
+    auto cgfe_tcam = generate_cgfe_tcam_entries(CGFE_encode_ports(port_table, cfg.cgfe, pool));
+
+    // Step 4: splice each output, then record the new build
+    SpliceInput in{old_of_new, fresh_rid, ip_table, fresh.size(), old};
+    string tmp[RELOAD_OUTPUTS];
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+        tmp[o] = cfg.output_file[o] + ".tmp";
+
+    SRGETcamStream srge_out;
+    DIRPETcamStream dirpe_out;
+    CGFETcamStream cgfe_out;
+    bool ok = srge_out.open(tmp[RELOAD_SRGE]) &&
+              splice_output(RELOAD_SRGE, cfg.output_file[RELOAD_SRGE], srge_out, tmp[RELOAD_SRGE],
+                            srge_tcam, in, lines, st);
+    ok = ok && dirpe_out.open(tmp[RELOAD_DIRPE]) &&
+         splice_output(RELOAD_DIRPE, cfg.output_file[RELOAD_DIRPE], dirpe_out, tmp[RELOAD_DIRPE],
+                       dirpe_tcam, in, lines, st);
+    ok = ok && cgfe_out.open(tmp[RELOAD_CGFE], cfg.cgfe) &&
+         splice_output(RELOAD_CGFE, cfg.output_file[RELOAD_CGFE], cgfe_out, tmp[RELOAD_CGFE],
+                       cgfe_tcam, in, lines, st);
+    if (!ok)
+        return false;
+
+    if (!save_state(cfg, lines))
+    {
+        fprintf(stderr, "[WARN] Cannot save reload state: %s\n", cfg.state_file.c_str());
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+/** *************************************************************/
+// @Name: Reload.hpp
+// @Function: Incremental rebuild of the TCAM rule files after a rule-file edit
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-02
+// @Description: Per-line hashes + line diff; only changed lines are re-encoded
+/************************************************************* */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "CGFE_code.hpp"
+#include "TcamWriter.hpp"
+
+// ===============================================================================
+// Configuration / Statistics
+// ===============================================================================
+
+enum ReloadOutput : int
+{
+    RELOAD_SRGE,
+    RELOAD_DIRPE,
+    RELOAD_CGFE,
+    RELOAD_OUTPUTS
+};
+
+struct ReloadConfig
+{
+    std::string output_file[RELOAD_OUTPUTS]; // SRGE / DIRPE / CGFE TCAM files
+    std::string state_file;                  // Line hashes and output sizes of the last build
+    int chunk_width = 2;                     // DIRPE W
+    CGFEConfig cgfe;
+    int threads = 1;
+    ThreadPool *pool = nullptr; // Used instead of a pool of `threads` when set
+};
+
+struct ReloadStats
+{
+    bool incremental = false; // false: no usable state, every line was encoded
+    size_t lines = 0;         // Lines in the new rule file
+    size_t reused = 0;        // Lines whose output was copied from the old files
+    size_t encoded = 0;       // Inserted or modified lines (parsed and encoded)
+    size_t removed = 0;       // Old lines deleted or modified
+    uint64_t entries[RELOAD_OUTPUTS] = {}; // Entries in each new file
+    uint64_t added[RELOAD_OUTPUTS] = {};   // "+" entries in each delta
+    uint64_t dropped[RELOAD_OUTPUTS] = {}; // "-" entries in each delta
+    TcamWriteStats write[RELOAD_OUTPUTS];
+};
+
+// ===============================================================================
+// Reload API
+// ===============================================================================
+
+// Delta written next to a TCAM file: "<file without extension>.delta"
+std::string delta_path_for(const std::string &output_file);
+
+// Rebuild the three TCAM files of rules_path. Lines unchanged since the build
+// recorded in cfg.state_file keep their old output bytes; only inserted and
+// modified lines are parsed and encoded (the first run encodes everything).
+// Also writes one delta per output ("- " removed / "+ " added entry lines)
+// and the new state. Throws like load_rules_from_file on malformed input;
+// returns false on I/O errors.
+bool reload_tcam_outputs(const std::string &rules_path, const ReloadConfig &cfg, ReloadStats &stats);
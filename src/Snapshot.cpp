@@ -0,0 +1,288 @@
+/** *************************************************************/
+// @Name: Snapshot.cpp
+// @Function: Versioned binary snapshot of a parsed rule file
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-28
+/************************************************************* */
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+#include <sys/stat.h>
+
+#include "Snapshot.hpp"
+
+using namespace std;
+
+// ===============================================================================
+// Module 1: Helpers
+// ===============================================================================
+
+namespace {
+
+// Element size of each per-rule column (0 for the action and tuple columns)
+constexpr size_t SNAP_ELEM_SIZE[SNAP_COL_COUNT] = {
+    4, 4, 4, 4,    // IP lo/hi
+    2, 2, 2, 2,    // port lo/hi
+    1, 1,          // proto lo/hi
+    1, 1, 1, 1, 1, // prefix_length[0..4]
+    4,             // priority
+    2,             // action id
+    0, 0,          // action table
+    0, 0,          // rmax_id, merged_offs (per tuple)
+    4, 4,          // merged_rids, tuple_of
+};
+
+// Byte size of column c; the action characters are checked separately
+uint64_t column_size(uint32_t c, uint64_t rules, uint64_t tuples, uint64_t actions) {
+    switch (c) {
+    case SNAP_ACTION_OFFS: return (actions + 1) * sizeof(uint32_t);
+    case SNAP_IP_RMAX_ID: return tuples * sizeof(uint32_t);
+    case SNAP_IP_MERGED_OFFS: return (tuples + 1) * sizeof(uint32_t);
+    default: return SNAP_ELEM_SIZE[c] * rules;
+    }
+}
+
+bool stat_file(const string &path, uint64_t &size, int64_t &mtime_ns) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    size = (uint64_t)st.st_size;
+    mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+} // namespace
+
+string snapshot_path_for(const string &rules_path) {
+    return rules_path + ".snap";
+}
+
+// ===============================================================================
+// Module 2: Save
+// ===============================================================================
+
+bool save_rule_snapshot(const string &snapshot_path, const RuleTable &rules, const IPTable &ip_table,
+                        const string &source_path) {
+    const size_t n = rules.size();
+    const IPTupleColumns &tuples = ip_table.columns();
+
+    vector<uint32_t> action_offs{0};
+    string action_chars;
+    for (const string &a : rules.actions) {
+        action_chars += a;
+        action_offs.push_back((uint32_t)action_chars.size());
+    }
+
+    SnapshotHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.endian_tag = SNAPSHOT_ENDIAN_TAG;
+    hdr.rule_count = n;
+    hdr.action_count = rules.actions.size();
+    hdr.tuple_count = tuples.tuples;
+    if (!stat_file(source_path, hdr.source_size, hdr.source_mtime_ns)) {
+        fprintf(stderr, "[WARN] Snapshot not saved: cannot stat %s\n", source_path.c_str());
+        return false;
+    }
+
+    size_t offset = align8(sizeof(hdr));
+    for (uint32_t c = 0; c < SNAP_COL_COUNT; ++c) {
+        size_t bytes = column_size(c, n, tuples.tuples, rules.actions.size());
+        if (c == SNAP_ACTION_CHARS) bytes = action_chars.size();
+        hdr.column_offset[c] = offset;
+        hdr.column_bytes[c] = bytes;
+        offset = align8(offset + bytes);
+    }
+    hdr.file_size = offset;
+
+    // The image is the tables' columns laid end to end
+    vector<char> image(offset, 0);
+    memcpy(image.data(), &hdr, sizeof(hdr));
+    auto put = [&](SnapshotColumn c, const auto &column) {
+        if (hdr.column_bytes[c]) memcpy(image.data() + hdr.column_offset[c], column.data(), hdr.column_bytes[c]);
+    };
+    auto put_raw = [&](SnapshotColumn c, const void *src) {
+        if (hdr.column_bytes[c]) memcpy(image.data() + hdr.column_offset[c], src, hdr.column_bytes[c]);
+    };
+    auto col = [&](SnapshotColumn c) { return image.data() + hdr.column_offset[c]; };
+
+    put(SNAP_SRC_IP_LO, rules.src_ip_lo);
+    put(SNAP_SRC_IP_HI, rules.src_ip_hi);
+    put(SNAP_DST_IP_LO, rules.dst_ip_lo);
+    put(SNAP_DST_IP_HI, rules.dst_ip_hi);
+    put(SNAP_SRC_PORT_LO, rules.src_port_lo);
+    put(SNAP_SRC_PORT_HI, rules.src_port_hi);
+    put(SNAP_DST_PORT_LO, rules.dst_port_lo);
+    put(SNAP_DST_PORT_HI, rules.dst_port_hi);
+    put(SNAP_PROTO_LO, rules.proto_lo);
+    put(SNAP_PROTO_HI, rules.proto_hi);
+    for (int d = 0; d < 5; ++d) {
+        put((SnapshotColumn)(SNAP_PREFIX_0 + d), rules.prefix_length[d]);
+    }
+    put(SNAP_PRIORITY, rules.priority);
+    put(SNAP_ACTION_ID, rules.action_id);
+    memcpy(col(SNAP_ACTION_OFFS), action_offs.data(), action_offs.size() * sizeof(uint32_t));
+    memcpy(col(SNAP_ACTION_CHARS), action_chars.data(), action_chars.size());
+    put_raw(SNAP_IP_RMAX_ID, tuples.rmax_id);
+    put_raw(SNAP_IP_MERGED_OFFS, tuples.merged_offs);
+    put_raw(SNAP_IP_MERGED_RIDS, tuples.merged_rids);
+    put_raw(SNAP_IP_TUPLE_OF, tuples.tuple_of);
+
+    // Write to a temporary file, then rename: readers never see a torn snapshot
+    string tmp = snapshot_path + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        fprintf(stderr, "[WARN] Snapshot not saved: cannot open %s\n", tmp.c_str());
+        return false;
+    }
+    bool ok = fwrite(image.data(), 1, image.size(), fp) == image.size();
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), snapshot_path.c_str()) != 0) {
+        fprintf(stderr, "[WARN] Snapshot not saved: write to %s failed\n", snapshot_path.c_str());
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ===============================================================================
+// Module 3: Load
+// ===============================================================================
+
+bool snapshot_is_fresh(const string &snapshot_path, const string &source_path) {
+    uint64_t snap_size, src_size;
+    int64_t snap_mtime, src_mtime;
+    if (!stat_file(snapshot_path, snap_size, snap_mtime) || !stat_file(source_path, src_size, src_mtime)) {
+        return false;
+    }
+    if (snap_mtime < src_mtime || snap_size < sizeof(SnapshotHeader)) return false;
+
+    // The header must describe the source as it is now (guards against mtime-preserving copies)
+    FILE *fp = fopen(snapshot_path.c_str(), "rb");
+    if (!fp) return false;
+    SnapshotHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, fp) == 1;
+    fclose(fp);
+    return ok && hdr.source_size == src_size && hdr.source_mtime_ns == src_mtime;
+}
+
+bool RuleSnapshot::open(const string &path) {
+    hdr_ = nullptr;
+    if (!file_.open(path)) {
+        fprintf(stderr, "[WARN] Cannot open snapshot: %s\n", path.c_str());
+        return false;
+    }
+
+    auto reject = [&](const char *why) {
+        fprintf(stderr, "[WARN] Ignoring snapshot %s: %s\n", path.c_str(), why);
+        hdr_ = nullptr;
+        file_.close();
+        return false;
+    };
+
+    if (file_.size() < sizeof(SnapshotHeader)) return reject("truncated header");
+    const SnapshotHeader *hdr = reinterpret_cast<const SnapshotHeader *>(file_.data());
+    if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic)) != 0) return reject("bad magic");
+    if (hdr->version != SNAPSHOT_VERSION) return reject("unsupported version");
+    if (hdr->endian_tag != SNAPSHOT_ENDIAN_TAG) return reject("foreign byte order");
+    if (hdr->file_size != file_.size()) return reject("size mismatch");
+
+    const uint64_t n = hdr->rule_count;
+    const uint64_t tuples = hdr->tuple_count;
+    if (n > file_.size() || hdr->action_count > (uint64_t)UINT16_MAX + 1 || tuples > n || (n && !tuples)) {
+        return reject("bad counts");
+    }
+    for (uint32_t c = 0; c < SNAP_COL_COUNT; ++c) {
+        uint64_t expect = column_size(c, n, tuples, hdr->action_count);
+        if (c == SNAP_ACTION_CHARS) expect = hdr->column_bytes[c];
+        if (hdr->column_bytes[c] != expect || hdr->column_offset[c] % 8 != 0 ||
+            hdr->column_offset[c] > file_.size() || expect > file_.size() - hdr->column_offset[c]) {
+            return reject("bad column table");
+        }
+    }
+    hdr_ = hdr;
+
+    // Action table and ids must stay in bounds
+    const uint32_t *offs = column<uint32_t>(SNAP_ACTION_OFFS);
+    for (uint64_t a = 0; a < hdr->action_count; ++a) {
+        if (offs[a] > offs[a + 1]) return reject("bad action table");
+    }
+    if (offs[hdr->action_count] != hdr->column_bytes[SNAP_ACTION_CHARS]) return reject("bad action table");
+    unordered_set<string_view> distinct;
+    for (uint64_t a = 0; a < hdr->action_count; ++a) {
+        if (!distinct.insert(action((uint16_t)a)).second) return reject("duplicate action");
+    }
+    const uint16_t *ids = column<uint16_t>(SNAP_ACTION_ID);
+    for (uint64_t i = 0; i < n; ++i) {
+        if (ids[i] >= hdr->action_count) return reject("action id out of range");
+    }
+
+    // IP tuple index: every offset and row / tuple id in bounds
+    const uint32_t *rmax = column<uint32_t>(SNAP_IP_RMAX_ID);
+    const uint32_t *moffs = column<uint32_t>(SNAP_IP_MERGED_OFFS);
+    const uint32_t *mrids = column<uint32_t>(SNAP_IP_MERGED_RIDS);
+    const uint32_t *tuple_of = column<uint32_t>(SNAP_IP_TUPLE_OF);
+    if (moffs[0] != 0 || moffs[tuples] != n) return reject("bad IP tuple index");
+    for (uint64_t t = 0; t < tuples; ++t) {
+        if (rmax[t] >= n || moffs[t] > moffs[t + 1]) return reject("bad IP tuple index");
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        if (mrids[i] >= n || tuple_of[i] >= tuples) return reject("bad IP tuple index");
+    }
+
+    actions_.clear();
+    for (uint64_t a = 0; a < hdr->action_count; ++a) {
+        actions_.emplace_back(action((uint16_t)a));
+    }
+    return true;
+}
+
+// ===============================================================================
+// Module 4: Tables over the Mapping
+// ===============================================================================
+
+RuleColumns RuleSnapshot::columns() const {
+    RuleColumns c;
+    c.rows = size();
+    c.src_ip_lo = column<uint32_t>(SNAP_SRC_IP_LO);
+    c.src_ip_hi = column<uint32_t>(SNAP_SRC_IP_HI);
+    c.dst_ip_lo = column<uint32_t>(SNAP_DST_IP_LO);
+    c.dst_ip_hi = column<uint32_t>(SNAP_DST_IP_HI);
+    c.src_port_lo = column<uint16_t>(SNAP_SRC_PORT_LO);
+    c.src_port_hi = column<uint16_t>(SNAP_SRC_PORT_HI);
+    c.dst_port_lo = column<uint16_t>(SNAP_DST_PORT_LO);
+    c.dst_port_hi = column<uint16_t>(SNAP_DST_PORT_HI);
+    c.proto_lo = column<uint8_t>(SNAP_PROTO_LO);
+    c.proto_hi = column<uint8_t>(SNAP_PROTO_HI);
+    for (int d = 0; d < 5; ++d) {
+        c.prefix_length[d] = column<uint8_t>((SnapshotColumn)(SNAP_PREFIX_0 + d));
+    }
+    c.priority = column<uint32_t>(SNAP_PRIORITY);
+    c.action_id = column<uint16_t>(SNAP_ACTION_ID);
+    c.actions = &actions_;
+    return c;
+}
+
+IPTupleColumns RuleSnapshot::ip_tuples() const {
+    IPTupleColumns t;
+    t.tuples = (size_t)hdr_->tuple_count;
+    t.rmax_id = column<uint32_t>(SNAP_IP_RMAX_ID);
+    t.merged_offs = column<uint32_t>(SNAP_IP_MERGED_OFFS);
+    t.merged_rids = column<uint32_t>(SNAP_IP_MERGED_RIDS);
+    t.tuple_of = column<uint32_t>(SNAP_IP_TUPLE_OF);
+    return t;
+}
+
+void split_rules(const RuleSnapshot &snap, IPTable &ip_table, PortTable &port_table) {
+    RuleColumns rules = snap.columns();
+    ip_table = IPTable(rules, snap.ip_tuples());
+    port_table = PortTable(rules, 0, (uint32_t)rules.size());
+
+    cout << "[split_rules] IP table size = " << ip_table.size()
+         << " (" << rules.size() << " rules, tuples from snapshot)"
+         << ", Port table size = " << port_table.size() << endl;
+}
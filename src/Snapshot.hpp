@@ -0,0 +1,131 @@
+/** *************************************************************/
+// @Name: Snapshot.hpp
+// @Function: Versioned binary snapshot of a parsed rule file
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-28
+// @Description: RuleTable columns + IP tuple index + action table, mmapped and used in place
+/************************************************************* */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Loader.hpp"
+#include "MappedFile.hpp"
+
+// ===============================================================================
+// File Layout (native endianness, every column 8-byte aligned)
+// ===============================================================================
+//
+//   SnapshotHeader
+//   column[SNAP_COL_COUNT]     rule_count elements each (tuple and action columns differ)
+//
+// Rule columns are the RuleTable columns byte for byte and the SNAP_IP_*
+// columns are the IPTable of those rules, so a snapshot is not read at all:
+// RuleColumns / IPTable / PortTable point straight into the mapping and pages
+// are faulted in as the encoders touch them. No parse, no copy, no IP merge.
+
+constexpr char SNAPSHOT_MAGIC[8] = {'R', 'U', 'L', 'E', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+constexpr uint32_t SNAPSHOT_ENDIAN_TAG = 0x01020304;
+
+enum SnapshotColumn : uint32_t
+{
+    SNAP_SRC_IP_LO,    // uint32_t
+    SNAP_SRC_IP_HI,    // uint32_t
+    SNAP_DST_IP_LO,    // uint32_t
+    SNAP_DST_IP_HI,    // uint32_t
+    SNAP_SRC_PORT_LO,  // uint16_t
+    SNAP_SRC_PORT_HI,  // uint16_t
+    SNAP_DST_PORT_LO,  // uint16_t
+    SNAP_DST_PORT_HI,  // uint16_t
+    SNAP_PROTO_LO,     // uint8_t
+    SNAP_PROTO_HI,     // uint8_t
+    SNAP_PREFIX_0,     // uint8_t, Rule5D::prefix_length[0..4]
+    SNAP_PREFIX_1,
+    SNAP_PREFIX_2,
+    SNAP_PREFIX_3,
+    SNAP_PREFIX_4,
+    SNAP_PRIORITY,     // uint32_t
+    SNAP_ACTION_ID,    // uint16_t, index into the action table
+    SNAP_ACTION_OFFS,  // uint32_t[action_count + 1], byte offsets into SNAP_ACTION_CHARS
+    SNAP_ACTION_CHARS, // char[]
+    SNAP_IP_RMAX_ID,     // uint32_t[tuple_count], IPTupleColumns
+    SNAP_IP_MERGED_OFFS, // uint32_t[tuple_count + 1]
+    SNAP_IP_MERGED_RIDS, // uint32_t
+    SNAP_IP_TUPLE_OF,    // uint32_t
+    SNAP_COL_COUNT
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint64_t rule_count;
+    uint64_t action_count;
+    uint64_t tuple_count;     // Distinct IP tuples (IPTable::size)
+    uint64_t source_size;     // Source .rules file at save time
+    int64_t source_mtime_ns;
+    uint64_t file_size;
+    uint64_t column_offset[SNAP_COL_COUNT];
+    uint64_t column_bytes[SNAP_COL_COUNT];
+};
+
+// ===============================================================================
+// RuleSnapshot: read-only view over a mapped snapshot
+// ===============================================================================
+
+class RuleSnapshot
+{
+public:
+    // Maps and validates the file; prints [WARN] and returns false if unusable
+    bool open(const std::string &path);
+
+    size_t size() const { return (size_t)hdr_->rule_count; }
+    size_t action_count() const { return (size_t)hdr_->action_count; }
+
+    template <class T>
+    const T *column(SnapshotColumn col) const
+    {
+        return reinterpret_cast<const T *>(file_.data() + hdr_->column_offset[col]);
+    }
+
+    std::string_view action(uint16_t id) const
+    {
+        const uint32_t *offs = column<uint32_t>(SNAP_ACTION_OFFS);
+        return std::string_view(column<char>(SNAP_ACTION_CHARS) + offs[id], offs[id + 1] - offs[id]);
+    }
+
+    // Rule columns inside the mapping; valid while this snapshot is open
+    RuleColumns columns() const;
+    IPTupleColumns ip_tuples() const;
+
+private:
+    MappedFile file_;
+    const SnapshotHeader *hdr_ = nullptr;
+    std::vector<std::string> actions_; // The only part held outside the mapping
+};
+
+// ===============================================================================
+// Snapshot API
+// ===============================================================================
+
+// Default snapshot location for a rules file: "<rules_path>.snap"
+std::string snapshot_path_for(const std::string &rules_path);
+
+// Write rules (as loaded from source_path) and their IP table to
+// snapshot_path; false on I/O error. ip_table must be built over rules.
+bool save_rule_snapshot(const std::string &snapshot_path,
+                        const RuleTable &rules,
+                        const IPTable &ip_table,
+                        const std::string &source_path);
+
+// Snapshot exists, is newer than the source, and records the source's current size / mtime
+bool snapshot_is_fresh(const std::string &snapshot_path, const std::string &source_path);
+
+// split_rules over a mapped snapshot: the IP tuples are read from it, no merge.
+// Both tables point into the mapping, so snap must stay open while they are used.
+void split_rules(const RuleSnapshot &snap, IPTable &ip_table, PortTable &port_table);
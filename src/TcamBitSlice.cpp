@@ -0,0 +1,259 @@
+/** *************************************************************/
+// @Name: TcamBitSlice.cpp
+// @Function: Bit-sliced (bit-vector) classifier over the SRGE / DIRPE / CGFE tables
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-05
+/************************************************************* */
+
+#include <algorithm>
+#include <immintrin.h>
+
+#include "TcamBitSlice.hpp"
+
+using namespace std;
+
+// ===============================================================================
+// Module 1: Build
+// ===============================================================================
+
+namespace {
+
+// Key bit p (word * 64 + bit) of a TcamKey
+inline uint64_t key_bit(const TcamKey &k, int p)
+{
+    return (k.w[p >> 6] >> (p & 63)) & 1;
+}
+
+// AND order: src / dst IP interleaved from the top bit, then protocol, then
+// both port keys from their first symbol
+vector<uint16_t> candidate_bits(int port_bits)
+{
+    vector<uint16_t> bits;
+    for (int b = 31; b >= 0; --b)
+    {
+        bits.push_back((uint16_t)(32 + b)); // src IP
+        bits.push_back((uint16_t)b);        // dst IP
+    }
+    for (int b = 7; b >= 0; --b)
+        bits.push_back((uint16_t)(3 * 64 + b));
+    for (int b = port_bits - 1; b >= 0; --b)
+    {
+        bits.push_back((uint16_t)(1 * 64 + b));
+        bits.push_back((uint16_t)(2 * 64 + b));
+    }
+    return bits;
+}
+
+} // namespace
+
+void BitSlicedTcam::build(const SoftwareTcam &tcam)
+{
+    ports_ = tcam.port_encoder();
+    rows_ = tcam.size();
+    blocks_ = (rows_ + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES;
+    actions_ = tcam.actions();
+    priority_.resize(rows_);
+    action_id_.resize(rows_);
+
+    vector<TcamRow> rows(rows_);
+    for (size_t i = 0; i < rows_; ++i)
+    {
+        rows[i] = tcam.row(i);
+        priority_[i] = tcam.priority(i);
+        action_id_[i] = tcam.action_id(i);
+    }
+
+    // Keep only key bits some entry cares about
+    bits_.clear();
+    for (uint16_t p : candidate_bits(ports_.key_bits()))
+    {
+        for (const TcamRow &r : rows)
+        {
+            if (key_bit(r.mask, p))
+            {
+                bits_.push_back(p);
+                break;
+            }
+        }
+    }
+
+    // Padding entries of the last block stay 0 in every vector: never match
+    const size_t nbits = bits_.size();
+    const size_t stride = nbits * 2 * BLOCK_WORDS;
+    slices_.assign(blocks_ * stride, 0);
+    for (size_t e = 0; e < rows_; ++e)
+    {
+        const TcamRow &r = rows[e];
+        uint64_t *block = slices_.data() + (e / BLOCK_ENTRIES) * stride;
+        size_t word = (e % BLOCK_ENTRIES) / 64;
+        uint64_t bit = 1ULL << (e % 64);
+        for (size_t k = 0; k < nbits; ++k)
+        {
+            int p = bits_[k];
+            bool care = key_bit(r.mask, p);
+            bool value = key_bit(r.value, p);
+            if (!care || !value)
+                block[(k * 2 + 0) * BLOCK_WORDS + word] |= bit;
+            if (!care || value)
+                block[(k * 2 + 1) * BLOCK_WORDS + word] |= bit;
+        }
+    }
+    set_kernel(kernel_);
+}
+
+void BitSlicedTcam::load(const std::vector<GrayTCAM_Entry> &entries, const IPTable &ip_table)
+{
+    SoftwareTcam tcam;
+    tcam.load(entries, ip_table);
+    build(tcam);
+}
+
+void BitSlicedTcam::load(const std::vector<DIRPETCAM_Entry> &entries, const IPTable &ip_table, int chunk_width)
+{
+    SoftwareTcam tcam;
+    tcam.load(entries, ip_table, chunk_width);
+    build(tcam);
+}
+
+void BitSlicedTcam::load(const std::vector<CGFETCAM_Entry> &entries, const IPTable &ip_table,
+                         const CGFEConfig &config)
+{
+    SoftwareTcam tcam;
+    tcam.load(entries, ip_table, config);
+    build(tcam);
+}
+
+// ===============================================================================
+// Module 2: Block Kernels
+// ===============================================================================
+//
+// AND the selected vectors of one block; every 8 bits, leave early if the
+// running AND is already zero. Returns the first set entry or -1.
+
+namespace {
+
+constexpr int W = BitSlicedTcam::BLOCK_WORDS;
+
+int block_scalar(const uint64_t *block, const uint32_t *select, int nbits)
+{
+    uint64_t acc[W];
+    for (int j = 0; j < W; ++j)
+        acc[j] = ~0ULL;
+    for (int k = 0; k < nbits; ++k)
+    {
+        const uint64_t *v = block + select[k];
+        uint64_t any = 0;
+        for (int j = 0; j < W; ++j)
+            any |= (acc[j] &= v[j]);
+        if ((k & 7) == 7 && !any)
+            return -1;
+    }
+    for (int j = 0; j < W; ++j)
+        if (acc[j])
+            return j * 64 + __builtin_ctzll(acc[j]);
+    return -1;
+}
+
+__attribute__((target("avx2"))) int block_avx2(const uint64_t *block, const uint32_t *select, int nbits)
+{
+    __m256i a0 = _mm256_set1_epi64x(-1), a1 = a0;
+    for (int k = 0; k < nbits; ++k)
+    {
+        const __m256i *v = (const __m256i *)(block + select[k]);
+        a0 = _mm256_and_si256(a0, _mm256_loadu_si256(v));
+        a1 = _mm256_and_si256(a1, _mm256_loadu_si256(v + 1));
+        if ((k & 7) == 7)
+        {
+            __m256i any = _mm256_or_si256(a0, a1);
+            if (_mm256_testz_si256(any, any))
+                return -1;
+        }
+    }
+    alignas(32) uint64_t acc[W];
+    _mm256_store_si256((__m256i *)acc, a0);
+    _mm256_store_si256((__m256i *)(acc + 4), a1);
+    for (int j = 0; j < W; ++j)
+        if (acc[j])
+            return j * 64 + __builtin_ctzll(acc[j]);
+    return -1;
+}
+
+__attribute__((target("avx512f"))) int block_avx512(const uint64_t *block, const uint32_t *select, int nbits)
+{
+    __m512i a = _mm512_set1_epi64(-1);
+    for (int k = 0; k < nbits; ++k)
+    {
+        a = _mm512_and_si512(a, _mm512_loadu_si512((const void *)(block + select[k])));
+        if ((k & 7) == 7 && _mm512_test_epi64_mask(a, a) == 0)
+            return -1;
+    }
+    __mmask8 nz = _mm512_test_epi64_mask(a, a);
+    if (!nz)
+        return -1;
+    alignas(64) uint64_t acc[W];
+    _mm512_store_si512((void *)acc, a);
+    int j = __builtin_ctz((unsigned)nz);
+    return j * 64 + __builtin_ctzll(acc[j]);
+}
+
+} // namespace
+
+TcamKernel BitSlicedTcam::set_kernel(TcamKernel kernel)
+{
+    kernel_ = resolve_tcam_kernel(kernel);
+    switch (kernel_)
+    {
+    case TcamKernel::AVX512:
+        block_ = block_avx512;
+        break;
+    case TcamKernel::AVX2:
+        block_ = block_avx2;
+        break;
+    default:
+        block_ = block_scalar;
+        break;
+    }
+    return kernel_;
+}
+
+// ===============================================================================
+// Module 3: Classification
+// ===============================================================================
+
+TcamMatch BitSlicedTcam::classify_key(const TcamKey &key) const
+{
+    // Offset of the selected vector of each stored bit inside a block
+    const int nbits = (int)bits_.size();
+    uint32_t select[4 * 64];
+    for (int k = 0; k < nbits; ++k)
+        select[k] = (uint32_t)((k * 2 + (int)key_bit(key, bits_[k])) * BLOCK_WORDS);
+
+    TcamMatch m;
+    const size_t stride = (size_t)nbits * 2 * BLOCK_WORDS;
+    const uint64_t *block = slices_.data();
+    for (size_t b = 0; b < blocks_; ++b, block += stride)
+    {
+        int e = block_(block, select, nbits);
+        if (e >= 0)
+        {
+            size_t i = b * BLOCK_ENTRIES + (size_t)e;
+            m.entry = (uint32_t)i;
+            m.priority = priority_[i];
+            m.action_id = action_id_[i];
+            break;
+        }
+    }
+    return m;
+}
+
+void BitSlicedTcam::classify_batch(const PacketHeader *pkts, size_t n, TcamMatch *out) const
+{
+    TcamKey keys[TCAM_KEY_BATCH];
+    for (size_t base = 0; base < n; base += TCAM_KEY_BATCH)
+    {
+        size_t count = min(n - base, TCAM_KEY_BATCH);
+        make_tcam_keys(pkts + base, count, ports_, keys);
+        for (size_t i = 0; i < count; ++i)
+            out[base + i] = classify_key(keys[i]);
+    }
+}
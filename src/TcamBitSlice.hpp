@@ -0,0 +1,83 @@
+/** *************************************************************/
+// @Name: TcamBitSlice.hpp
+// @Function: Bit-sliced (bit-vector) classifier over the SRGE / DIRPE / CGFE tables
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-05
+// @Description: Per key bit, "matches 0" / "matches 1" entry bitvectors ANDed per lookup
+/************************************************************* */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TcamLookup.hpp"
+
+// ===============================================================================
+// BitSlicedTcam
+// ===============================================================================
+//
+// For every key bit b and bit value x there is one bitvector over all entries:
+// bit e is set iff entry e accepts x at b (care bit equal to x, or '*').
+// A lookup ANDs the vectors selected by the key's bits; the lowest set bit of
+// the result is the first (highest priority) match. Cost grows with the key
+// width and N / 64 words, not with N ternary compares.
+//
+// Layout: entries are grouped into blocks of BLOCK_ENTRIES; each block stores
+// the vectors of all its key bits contiguously,
+//     slices[block][bit][x][BLOCK_WORDS],
+// so a lookup streams through memory in priority order and stops at the first
+// block with a hit. Within a block the IP bits are ANDed first (most
+// selective, high bits first) and the scan leaves the block as soon as the
+// running AND is zero. Key bits that no entry cares about are not stored.
+//
+// Entries come from a loaded SoftwareTcam (which does the IP join and the
+// priority order), so both engines classify the same table, including the
+// SRGE coverage gap described at SoftwareTcam.
+
+class BitSlicedTcam
+{
+public:
+    static constexpr int BLOCK_WORDS = 8; // One AVX-512 register
+    static constexpr size_t BLOCK_ENTRIES = 64 * BLOCK_WORDS;
+
+    BitSlicedTcam() { set_kernel(TcamKernel::Auto); }
+
+    void build(const SoftwareTcam &tcam);
+
+    // Expanded entries -> SoftwareTcam join -> slices
+    void load(const std::vector<GrayTCAM_Entry> &entries, const IPTable &ip_table);
+    void load(const std::vector<DIRPETCAM_Entry> &entries, const IPTable &ip_table, int chunk_width);
+    void load(const std::vector<CGFETCAM_Entry> &entries, const IPTable &ip_table, const CGFEConfig &config);
+
+    size_t size() const { return rows_; }
+    bool empty() const { return rows_ == 0; }
+    int key_bits() const { return (int)bits_.size(); } // Stored (non-wildcard) key bits
+    size_t memory_bytes() const { return slices_.size() * sizeof(uint64_t); }
+    const PortKeyEncoder &port_encoder() const { return ports_; }
+
+    // Same kernel choice as SoftwareTcam (CPUID-checked)
+    TcamKernel set_kernel(TcamKernel kernel);
+    TcamKernel kernel() const { return kernel_; }
+
+    TcamKey key_of(const PacketHeader &pkt) const { return make_tcam_key(pkt, ports_); }
+    TcamMatch classify(const PacketHeader &pkt) const { return classify_key(key_of(pkt)); }
+    TcamMatch classify_key(const TcamKey &key) const;
+    void classify_batch(const PacketHeader *pkts, size_t n, TcamMatch *out) const;
+
+    const std::string &action(uint16_t id) const { return actions_[id]; }
+
+    using BlockFn = int (*)(const uint64_t *block, const uint32_t *select, int nbits);
+
+private:
+    PortKeyEncoder ports_;
+    std::vector<uint16_t> bits_;   // Stored key bits in AND order: word * 64 + bit of TcamKey
+    std::vector<uint64_t> slices_; // [block][bit][x][BLOCK_WORDS]
+    size_t rows_ = 0;
+    size_t blocks_ = 0;
+    std::vector<uint32_t> priority_;
+    std::vector<uint16_t> action_id_;
+    std::vector<std::string> actions_;
+    TcamKernel kernel_ = TcamKernel::Scalar;
+    BlockFn block_ = nullptr;
+};
@@ -0,0 +1,512 @@
+/** *************************************************************/
+// @Name: TcamLookup.cpp
+// @Function: Software TCAM over the SRGE / DIRPE / CGFE entry tables
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-04
+/************************************************************* */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+#include <immintrin.h>
+
+#include "TcamLookup.hpp"
+
+using namespace std;
+
+// ===============================================================================
+// Module 1: Port Keys
+// ===============================================================================
+
+// One key per port value. Built from the reference encoders, so the lookup
+// keys are exactly the points the range encoders cover.
+struct PortKeyTable
+{
+    std::vector<uint32_t> key32;
+    std::vector<uint64_t> key64;
+};
+
+namespace {
+
+constexpr size_t PORT_VALUES = 1 << 16;
+
+// (encoding, parameter) -> table, kept for the life of the process
+const PortKeyTable &port_key_table(PortEncoding encoding, int chunk_width, const CGFEConfig &cgfe, int bits)
+{
+    static mutex lock;
+    static map<tuple<int, int, int>, unique_ptr<PortKeyTable>> tables;
+
+    tuple<int, int, int> id = encoding == PortEncoding::DIRPE
+                                  ? make_tuple((int)encoding, chunk_width, 0)
+                                  : make_tuple((int)encoding, cgfe.W, cgfe.c);
+    lock_guard<mutex> guard(lock);
+    unique_ptr<PortKeyTable> &table = tables[id];
+    if (table)
+    {
+        return *table;
+    }
+
+    table.reset(new PortKeyTable);
+    DIRPEConfig dirpe{chunk_width, 16};
+    auto key = [&](uint16_t x) -> uint64_t {
+        return encoding == PortEncoding::DIRPE ? (uint64_t)dirpe_value_pattern(x, dirpe).value
+                                               : (uint64_t)cgfe_value_pattern(x, cgfe).value;
+    };
+    if (bits <= 32)
+    {
+        table->key32.resize(PORT_VALUES);
+        for (size_t x = 0; x < PORT_VALUES; ++x)
+            table->key32[x] = (uint32_t)key((uint16_t)x);
+    }
+    else
+    {
+        table->key64.resize(PORT_VALUES);
+        for (size_t x = 0; x < PORT_VALUES; ++x)
+            table->key64[x] = key((uint16_t)x);
+    }
+    return *table;
+}
+
+} // namespace
+
+PortKeyEncoder PortKeyEncoder::srge()
+{
+    return PortKeyEncoder();
+}
+
+PortKeyEncoder PortKeyEncoder::dirpe(int chunk_width)
+{
+    PortKeyEncoder e;
+    e.encoding_ = PortEncoding::DIRPE;
+    e.chunk_width_ = chunk_width;
+    const PortKeyTable &t = port_key_table(e.encoding_, chunk_width, e.cgfe_, e.key_bits());
+    e.key32_ = t.key32.empty() ? nullptr : t.key32.data();
+    e.key64_ = t.key64.empty() ? nullptr : t.key64.data();
+    return e;
+}
+
+PortKeyEncoder PortKeyEncoder::cgfe(const CGFEConfig &config)
+{
+    PortKeyEncoder e;
+    e.encoding_ = PortEncoding::CGFE;
+    e.cgfe_ = config;
+    const PortKeyTable &t = port_key_table(e.encoding_, e.chunk_width_, config, e.key_bits());
+    e.key32_ = t.key32.empty() ? nullptr : t.key32.data();
+    e.key64_ = t.key64.empty() ? nullptr : t.key64.data();
+    return e;
+}
+
+int PortKeyEncoder::key_bits() const
+{
+    switch (encoding_)
+    {
+    case PortEncoding::SRGE:
+        return GRAY_BITS;
+    case PortEncoding::DIRPE:
+        return (16 / chunk_width_) * ((1 << chunk_width_) - 1);
+    case PortEncoding::CGFE:
+        return cgfe_.output_bits();
+    }
+    return 0;
+}
+
+void PortKeyEncoder::encode_batch(const uint16_t *ports, size_t n, uint64_t *keys) const
+{
+    if (key32_)
+    {
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = key32_[ports[i]];
+    }
+    else if (key64_)
+    {
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = key64_[ports[i]];
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = (uint64_t)(ports[i] ^ (ports[i] >> 1));
+    }
+}
+
+// ===============================================================================
+// Module 2: Loading
+// ===============================================================================
+
+namespace {
+
+inline uint32_t prefix_mask(int len)
+{
+    return len <= 0 ? 0u : len >= 32 ? 0xFFFFFFFFu : 0xFFFFFFFFu << (32 - len);
+}
+
+void push_field(TcamColumns &cols, int c, uint64_t value, uint64_t mask)
+{
+    cols.value[c].push_back((uint32_t)value);
+    cols.mask[c].push_back((uint32_t)mask);
+}
+
+// Never matches: protocol keys are 8 bits, this row needs bit 8 set
+void push_pad_row(TcamColumns &cols)
+{
+    for (int c = 0; c < TCOL_COUNT; ++c)
+    {
+        cols.value[c].push_back(0);
+        cols.mask[c].push_back(0);
+    }
+    cols.value[TCOL_PROTO].back() = 0x100;
+    cols.mask[TCOL_PROTO].back() = 0xFFFFFFFFu;
+}
+
+} // namespace
+
+template <typename Entry>
+void SoftwareTcam::load_entries(const std::vector<Entry> &entries, const IPTable &ip_table)
+{
+    for (int c = 0; c < TCOL_COUNT; ++c)
+    {
+        cols_.value[c].clear();
+        cols_.mask[c].clear();
+    }
+    cols_.wide = ports_.key_bits() > 32;
+    priority_.clear();
+    action_id_.clear();
+    actions_.clear();
+
+    // Rule priority order; entries of one rule keep their generation order
+    vector<uint32_t> order(entries.size());
+    iota(order.begin(), order.end(), 0u);
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return entries[a].priority < entries[b].priority;
+    });
+
+    size_t capacity = (entries.size() + TCAM_COLUMN_PAD - 1) / TCAM_COLUMN_PAD * TCAM_COLUMN_PAD;
+    for (int c = 0; c < TCOL_COUNT; ++c)
+    {
+        cols_.value[c].reserve(capacity);
+        cols_.mask[c].reserve(capacity);
+    }
+    priority_.reserve(entries.size());
+    action_id_.reserve(entries.size());
+
+    IPRuleIndex ip_index(ip_table);
+    for (uint32_t i : order)
+    {
+        const Entry &entry = entries[i];
+        IPRule ip_rule;
+        if (!ip_index.find(entry.rid, entry.priority, ip_rule))
+        {
+            cerr << "[WARN] No IP rule found for priority " << entry.priority << "\n";
+            continue;
+        }
+
+        uint32_t src_mask = prefix_mask(ip_rule.src_prefix_len);
+        uint32_t dst_mask = prefix_mask(ip_rule.dst_prefix_len);
+        bool proto_exact = ip_rule.proto == ip_rule.proto_hi;
+        uint64_t sport_v = (uint64_t)entry.src_pattern.value, sport_m = (uint64_t)entry.src_pattern.mask;
+        uint64_t dport_v = (uint64_t)entry.dst_pattern.value, dport_m = (uint64_t)entry.dst_pattern.mask;
+
+        push_field(cols_, TCOL_SRC_IP, ip_rule.src_ip_lo & src_mask, src_mask);
+        push_field(cols_, TCOL_DST_IP, ip_rule.dst_ip_lo & dst_mask, dst_mask);
+        push_field(cols_, TCOL_SRC_PORT, sport_v, sport_m);
+        push_field(cols_, TCOL_DST_PORT, dport_v, dport_m);
+        push_field(cols_, TCOL_PROTO, proto_exact ? ip_rule.proto : 0, proto_exact ? 0xFF : 0);
+        push_field(cols_, TCOL_SRC_PORT_HI, sport_v >> 32, sport_m >> 32);
+        push_field(cols_, TCOL_DST_PORT_HI, dport_v >> 32, dport_m >> 32);
+
+        priority_.push_back(entry.priority);
+        action_id_.push_back(entry.action_id);
+
+        if (entry.action_id >= actions_.size())
+        {
+            actions_.resize((size_t)entry.action_id + 1);
+        }
+        if (actions_[entry.action_id].empty())
+        {
+            actions_[entry.action_id] = ip_table.action(entry.action_id);
+        }
+    }
+
+    cols_.rows = priority_.size();
+    while (cols_.value[0].size() % TCAM_COLUMN_PAD)
+    {
+        push_pad_row(cols_);
+    }
+    cols_.padded = cols_.value[0].size();
+    set_kernel(kernel_request_);
+}
+
+void SoftwareTcam::load(const std::vector<GrayTCAM_Entry> &entries, const IPTable &ip_table)
+{
+    cerr << "[WARN] SRGE tables under-cover port ranges; first matches may be wrong"
+         << " (see SoftwareTcam in TcamLookup.hpp)\n";
+    ports_ = PortKeyEncoder::srge();
+    load_entries(entries, ip_table);
+}
+
+void SoftwareTcam::load(const std::vector<DIRPETCAM_Entry> &entries, const IPTable &ip_table, int chunk_width)
+{
+    ports_ = PortKeyEncoder::dirpe(chunk_width);
+    load_entries(entries, ip_table);
+}
+
+void SoftwareTcam::load(const std::vector<CGFETCAM_Entry> &entries, const IPTable &ip_table,
+                        const CGFEConfig &config)
+{
+    ports_ = PortKeyEncoder::cgfe(config);
+    load_entries(entries, ip_table);
+}
+
+// ===============================================================================
+// Module 3: Classification
+// ===============================================================================
+
+TcamKey make_tcam_key(const PacketHeader &pkt, const PortKeyEncoder &ports)
+{
+    TcamKey key;
+    key.w[0] = ((uint64_t)pkt.src_ip << 32) | pkt.dst_ip;
+    key.w[1] = ports.encode(pkt.src_port);
+    key.w[2] = ports.encode(pkt.dst_port);
+    key.w[3] = pkt.proto;
+    return key;
+}
+
+namespace {
+
+template <typename PortKey>
+void fill_keys(const PacketHeader *pkts, size_t n, TcamKey *keys, PortKey port_key)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        const PacketHeader &pkt = pkts[i];
+        TcamKey &key = keys[i];
+        key.w[0] = ((uint64_t)pkt.src_ip << 32) | pkt.dst_ip;
+        key.w[1] = port_key(pkt.src_port);
+        key.w[2] = port_key(pkt.dst_port);
+        key.w[3] = pkt.proto;
+    }
+}
+
+} // namespace
+
+void make_tcam_keys(const PacketHeader *pkts, size_t n, const PortKeyEncoder &ports, TcamKey *keys)
+{
+    if (const uint32_t *t = ports.key32_)
+        fill_keys(pkts, n, keys, [t](uint16_t p) { return (uint64_t)t[p]; });
+    else if (const uint64_t *t = ports.key64_)
+        fill_keys(pkts, n, keys, [t](uint16_t p) { return t[p]; });
+    else
+        fill_keys(pkts, n, keys, [](uint16_t p) { return (uint64_t)(p ^ (p >> 1)); });
+}
+
+TcamRow SoftwareTcam::row(size_t i) const
+{
+    auto word = [&](const std::vector<uint32_t> *col, int lo, int hi) {
+        return ((uint64_t)col[hi][i] << 32) | col[lo][i];
+    };
+    TcamRow r;
+    r.value.w[0] = word(cols_.value, TCOL_DST_IP, TCOL_SRC_IP);
+    r.mask.w[0] = word(cols_.mask, TCOL_DST_IP, TCOL_SRC_IP);
+    r.value.w[1] = word(cols_.value, TCOL_SRC_PORT, TCOL_SRC_PORT_HI);
+    r.mask.w[1] = word(cols_.mask, TCOL_SRC_PORT, TCOL_SRC_PORT_HI);
+    r.value.w[2] = word(cols_.value, TCOL_DST_PORT, TCOL_DST_PORT_HI);
+    r.mask.w[2] = word(cols_.mask, TCOL_DST_PORT, TCOL_DST_PORT_HI);
+    r.value.w[3] = cols_.value[TCOL_PROTO][i];
+    r.mask.w[3] = cols_.mask[TCOL_PROTO][i];
+    return r;
+}
+
+TcamMatch SoftwareTcam::classify_key(const TcamKey &key) const
+{
+    // Key split into the 32-bit lanes of the columns
+    uint32_t lanes[TCOL_COUNT] = {
+        (uint32_t)(key.w[0] >> 32), (uint32_t)key.w[0],
+        (uint32_t)key.w[1], (uint32_t)key.w[2], (uint32_t)key.w[3],
+        (uint32_t)(key.w[1] >> 32), (uint32_t)(key.w[2] >> 32)};
+
+    TcamMatch m;
+    uint32_t i = match_(cols_, lanes);
+    if (i != TcamMatch::NO_ENTRY)
+    {
+        m.entry = i;
+        m.priority = priority_[i];
+        m.action_id = action_id_[i];
+    }
+    return m;
+}
+
+void SoftwareTcam::classify_batch(const PacketHeader *pkts, size_t n, TcamMatch *out) const
+{
+    TcamKey keys[TCAM_KEY_BATCH];
+    for (size_t base = 0; base < n; base += TCAM_KEY_BATCH)
+    {
+        size_t count = min(n - base, TCAM_KEY_BATCH);
+        make_tcam_keys(pkts + base, count, ports_, keys);
+        for (size_t i = 0; i < count; ++i)
+            out[base + i] = classify_key(keys[i]);
+    }
+}
+
+// ===============================================================================
+// Module 4: Match Kernels
+// ===============================================================================
+//
+// Each kernel returns the first row whose every column satisfies
+// ((key ^ value) & mask) == 0, or NO_ENTRY. The vector kernels are compiled
+// for their instruction set with target attributes and only called after
+// resolve_tcam_kernel() has checked CPUID, so the rest of the program keeps
+// the baseline -march.
+
+namespace {
+
+template <bool Wide>
+uint32_t match_scalar(const TcamColumns &cols, const uint32_t *key)
+{
+    constexpr int ncols = Wide ? TCOL_COUNT : TCOL_NARROW;
+    const uint32_t *v[ncols], *m[ncols];
+    for (int c = 0; c < ncols; ++c)
+    {
+        v[c] = cols.value[c].data();
+        m[c] = cols.mask[c].data();
+    }
+    for (size_t i = 0; i < cols.rows; ++i)
+    {
+        // IP columns first: they reject most rows
+        if (((key[TCOL_SRC_IP] ^ v[TCOL_SRC_IP][i]) & m[TCOL_SRC_IP][i]) |
+            ((key[TCOL_DST_IP] ^ v[TCOL_DST_IP][i]) & m[TCOL_DST_IP][i]))
+            continue;
+        uint32_t miss = 0;
+        for (int c = TCOL_SRC_PORT; c < ncols; ++c)
+            miss |= (key[c] ^ v[c][i]) & m[c][i];
+        if (!miss)
+            return (uint32_t)i;
+    }
+    return TcamMatch::NO_ENTRY;
+}
+
+template <bool Wide>
+__attribute__((target("avx2"))) uint32_t match_avx2(const TcamColumns &cols, const uint32_t *key)
+{
+    constexpr int ncols = Wide ? TCOL_COUNT : TCOL_NARROW;
+    const uint32_t *v[ncols], *m[ncols];
+    __m256i k[ncols];
+    for (int c = 0; c < ncols; ++c)
+    {
+        v[c] = cols.value[c].data();
+        m[c] = cols.mask[c].data();
+        k[c] = _mm256_set1_epi32((int)key[c]);
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    for (size_t i = 0; i < cols.padded; i += 8)
+    {
+        __m256i miss = zero;
+        for (int c = 0; c < ncols; ++c)
+        {
+            // After the IP columns, skip the block if no row is left
+            if (c == TCOL_SRC_PORT &&
+                _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(miss, zero))) == 0)
+                break;
+            __m256i val = _mm256_loadu_si256((const __m256i *)(v[c] + i));
+            __m256i msk = _mm256_loadu_si256((const __m256i *)(m[c] + i));
+            miss = _mm256_or_si256(miss, _mm256_and_si256(_mm256_xor_si256(k[c], val), msk));
+        }
+        int hit = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(miss, zero)));
+        if (hit)
+            return (uint32_t)(i + __builtin_ctz((unsigned)hit));
+    }
+    return TcamMatch::NO_ENTRY;
+}
+
+template <bool Wide>
+__attribute__((target("avx512f"))) uint32_t match_avx512(const TcamColumns &cols, const uint32_t *key)
+{
+    constexpr int ncols = Wide ? TCOL_COUNT : TCOL_NARROW;
+    const uint32_t *v[ncols], *m[ncols];
+    __m512i k[ncols];
+    for (int c = 0; c < ncols; ++c)
+    {
+        v[c] = cols.value[c].data();
+        m[c] = cols.mask[c].data();
+        k[c] = _mm512_set1_epi32((int)key[c]);
+    }
+    for (size_t i = 0; i < cols.padded; i += 16)
+    {
+        __m512i miss = _mm512_setzero_si512();
+        for (int c = 0; c < ncols; ++c)
+        {
+            // After the IP columns, skip the block if no row is left
+            if (c == TCOL_SRC_PORT && _mm512_testn_epi32_mask(miss, miss) == 0)
+                break;
+            __m512i val = _mm512_loadu_si512((const void *)(v[c] + i));
+            __m512i msk = _mm512_loadu_si512((const void *)(m[c] + i));
+            // 0x28: (key ^ value) & mask in one instruction
+            miss = _mm512_or_si512(miss, _mm512_ternarylogic_epi32(k[c], val, msk, 0x28));
+        }
+        __mmask16 hit = _mm512_testn_epi32_mask(miss, miss);
+        if (hit)
+            return (uint32_t)(i + __builtin_ctz((unsigned)hit));
+    }
+    return TcamMatch::NO_ENTRY;
+}
+
+bool cpu_has(TcamKernel kernel)
+{
+    switch (kernel)
+    {
+    case TcamKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case TcamKernel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+const char *tcam_kernel_name(TcamKernel kernel)
+{
+    switch (kernel)
+    {
+    case TcamKernel::Auto: return "auto";
+    case TcamKernel::Scalar: return "scalar";
+    case TcamKernel::AVX2: return "avx2";
+    case TcamKernel::AVX512: return "avx512";
+    }
+    return "?";
+}
+
+TcamKernel resolve_tcam_kernel(TcamKernel requested)
+{
+    if (requested != TcamKernel::Auto && cpu_has(requested))
+        return requested;
+    if (cpu_has(TcamKernel::AVX512))
+        return TcamKernel::AVX512;
+    if (cpu_has(TcamKernel::AVX2))
+        return TcamKernel::AVX2;
+    return TcamKernel::Scalar;
+}
+
+TcamKernel SoftwareTcam::set_kernel(TcamKernel kernel)
+{
+    kernel_request_ = kernel;
+    kernel_ = resolve_tcam_kernel(kernel);
+    bool wide = cols_.wide;
+    switch (kernel_)
+    {
+    case TcamKernel::AVX512:
+        match_ = wide ? match_avx512<true> : match_avx512<false>;
+        break;
+    case TcamKernel::AVX2:
+        match_ = wide ? match_avx2<true> : match_avx2<false>;
+        break;
+    default:
+        match_ = wide ? match_scalar<true> : match_scalar<false>;
+        break;
+    }
+    return kernel_;
+}
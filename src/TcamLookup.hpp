@@ -0,0 +1,234 @@
+/** *************************************************************/
+// @Name: TcamLookup.hpp
+// @Function: Software TCAM over the SRGE / DIRPE / CGFE entry tables
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-04
+// @Description: Packed value/mask rows in priority order, first-match classify()
+/************************************************************* */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CGFE_code.hpp"
+#include "Chunk_code.hpp"
+#include "Gray_code.hpp"
+#include "Loader.hpp"
+
+// ===============================================================================
+// Packet / Key Layout
+// ===============================================================================
+
+struct PacketHeader
+{
+    uint32_t src_ip = 0;
+    uint32_t dst_ip = 0;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t proto = 0;
+};
+
+// One TCAM row or search key, four 64-bit words:
+//   w[0] = src_ip << 32 | dst_ip
+//   w[1] = source port key      (SRGE: 16-bit Gray code, DIRPE/CGFE: fence symbols)
+//   w[2] = destination port key
+//   w[3] = protocol (low 8 bits)
+// A key k matches a row iff ((k.w[i] ^ value.w[i]) & mask.w[i]) == 0 for every i.
+constexpr int TCAM_KEY_WORDS = 4;
+
+struct TcamKey
+{
+    uint64_t w[TCAM_KEY_WORDS] = {};
+};
+
+struct TcamRow
+{
+    TcamKey value;
+    TcamKey mask; // 1 = care bit
+};
+
+enum class PortEncoding
+{
+    SRGE,
+    DIRPE,
+    CGFE
+};
+
+// Port -> search key of one encoding (all symbols are care bits).
+// SRGE keys are the Gray code x ^ (x >> 1). DIRPE / CGFE keys are read from a
+// 65536-entry table per parameter set, built once from the reference encoders
+// on first use and shared by all encoders with the same parameters (tables
+// live until exit: 256 KiB for keys of <= 32 symbols, 512 KiB above).
+struct PortKeyTable;
+
+class PortKeyEncoder
+{
+public:
+    PortKeyEncoder() = default; // SRGE
+    static PortKeyEncoder srge();
+    static PortKeyEncoder dirpe(int chunk_width);
+    static PortKeyEncoder cgfe(const CGFEConfig &config);
+
+    PortEncoding encoding() const { return encoding_; }
+    int chunk_width() const { return chunk_width_; } // DIRPE W
+    const CGFEConfig &cgfe_config() const { return cgfe_; }
+    int key_bits() const; // Symbols per port key (16 for SRGE)
+
+    uint64_t encode(uint16_t port) const
+    {
+        if (key32_)
+            return key32_[port];
+        if (key64_)
+            return key64_[port];
+        return (uint64_t)(port ^ (port >> 1));
+    }
+
+    // keys[i] = encode(ports[i]), i < n
+    void encode_batch(const uint16_t *ports, size_t n, uint64_t *keys) const;
+
+private:
+    friend void make_tcam_keys(const PacketHeader *, size_t, const PortKeyEncoder &, TcamKey *);
+
+    PortEncoding encoding_ = PortEncoding::SRGE;
+    int chunk_width_ = 2;
+    CGFEConfig cgfe_{16, 2};
+    const uint32_t *key32_ = nullptr; // Table of keys of <= 32 symbols
+    const uint64_t *key64_ = nullptr; // Table of wider keys
+};
+
+// Search key of a packet: ports translated by the table's encoder
+TcamKey make_tcam_key(const PacketHeader &pkt, const PortKeyEncoder &ports);
+
+// keys[i] = make_tcam_key(pkts[i], ports), i < n; the table choice is made
+// once per batch instead of once per port
+void make_tcam_keys(const PacketHeader *pkts, size_t n, const PortKeyEncoder &ports, TcamKey *keys);
+
+constexpr size_t TCAM_KEY_BATCH = 64; // Keys built ahead by classify_batch()
+
+struct TcamMatch
+{
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+    uint32_t entry = NO_ENTRY; // Row index (0 = highest priority)
+    uint32_t priority = 0;     // Rule priority of the row
+    uint16_t action_id = 0;
+
+    explicit operator bool() const { return entry != NO_ENTRY; }
+};
+
+// ===============================================================================
+// Column Storage / Match Kernels
+// ===============================================================================
+//
+// Rows are stored as SoA columns of 32-bit value/mask lanes, one column per
+// key field at its real width: 32 + 32 IP bits, the port keys (16-bit Gray
+// codes, 24-bit fences for W = 2 / c = 2) and the 8-bit protocol. Port keys
+// wider than 32 symbols (W = 4 / c = 4: 60 symbols) spill into two extra
+// high-half columns, which narrow tables leave empty.
+// Columns are padded with never-matching rows to a multiple of
+// TCAM_COLUMN_PAD, so the vector kernels have no tail loop.
+
+enum TcamColumn : int
+{
+    TCOL_SRC_IP,
+    TCOL_DST_IP,
+    TCOL_SRC_PORT,
+    TCOL_DST_PORT,
+    TCOL_PROTO,
+    TCOL_SRC_PORT_HI, // Wide port keys only
+    TCOL_DST_PORT_HI,
+    TCOL_COUNT
+};
+
+constexpr int TCOL_NARROW = TCOL_PROTO + 1;
+constexpr size_t TCAM_COLUMN_PAD = 16; // One AVX-512 block
+
+struct TcamColumns
+{
+    std::vector<uint32_t> value[TCOL_COUNT];
+    std::vector<uint32_t> mask[TCOL_COUNT];
+    size_t rows = 0;    // Real rows
+    size_t padded = 0;  // rows rounded up to TCAM_COLUMN_PAD
+    bool wide = false;  // High-half port columns in use
+};
+
+// First-match scan implementations; Auto picks the widest one the CPU has
+enum class TcamKernel
+{
+    Auto,
+    Scalar,
+    AVX2,   // 8 rows per compare
+    AVX512  // 16 rows per compare
+};
+
+const char *tcam_kernel_name(TcamKernel kernel);
+
+// Kernel the CPU can run for a request (Auto / unsupported -> best supported)
+TcamKernel resolve_tcam_kernel(TcamKernel requested);
+
+// ===============================================================================
+// SoftwareTcam
+// ===============================================================================
+//
+// load() joins every expanded port entry with the IP prefixes and protocol of
+// its rule (IPTable) and stores the rows sorted by rule priority, entries of
+// one rule in generation order. classify() scans the rows and returns the
+// first match, i.e. what a hardware TCAM with this table would report.
+// Action texts are copied, so the engine does not keep the tables alive.
+//
+// Caveat: SRGE tables are known to under-cover port ranges. srge_encode()
+// leaves some points of most arbitrary ranges unmatched (e.g. 16 ports of
+// 2500:2800), so an SRGE table can miss a rule and report a lower-priority
+// one or none. It never matches a port outside a range. DIRPE and CGFE tables
+// cover exactly. load() prints a [WARN] for SRGE tables.
+
+class SoftwareTcam
+{
+public:
+    SoftwareTcam() { set_kernel(TcamKernel::Auto); }
+
+    void load(const std::vector<GrayTCAM_Entry> &entries, const IPTable &ip_table);
+    void load(const std::vector<DIRPETCAM_Entry> &entries, const IPTable &ip_table, int chunk_width);
+    void load(const std::vector<CGFETCAM_Entry> &entries, const IPTable &ip_table, const CGFEConfig &config);
+
+    size_t size() const { return cols_.rows; }
+    bool empty() const { return cols_.rows == 0; }
+    TcamRow row(size_t i) const;
+    const TcamColumns &columns() const { return cols_; }
+    const PortKeyEncoder &port_encoder() const { return ports_; }
+
+    // Select the match kernel; returns the one actually used
+    TcamKernel set_kernel(TcamKernel kernel);
+    TcamKernel kernel() const { return kernel_; }
+
+    // Search key of a packet: ports translated into this table's encoding
+    TcamKey key_of(const PacketHeader &pkt) const { return make_tcam_key(pkt, ports_); }
+
+    // First matching row in priority order
+    TcamMatch classify(const PacketHeader &pkt) const { return classify_key(key_of(pkt)); }
+    TcamMatch classify_key(const TcamKey &key) const;
+
+    // out[i] = classify(pkts[i]), i < n; keys are built in batches
+    void classify_batch(const PacketHeader *pkts, size_t n, TcamMatch *out) const;
+
+    uint32_t priority(size_t i) const { return priority_[i]; }
+    uint16_t action_id(size_t i) const { return action_id_[i]; }
+    const std::string &action(uint16_t id) const { return actions_[id]; }
+    const std::vector<std::string> &actions() const { return actions_; }
+
+private:
+    template <typename Entry>
+    void load_entries(const std::vector<Entry> &entries, const IPTable &ip_table);
+
+    using MatchFn = uint32_t (*)(const TcamColumns &, const uint32_t *key);
+
+    PortKeyEncoder ports_;
+    TcamColumns cols_;
+    std::vector<uint32_t> priority_;
+    std::vector<uint16_t> action_id_;
+    std::vector<std::string> actions_; // Indexed by action id
+    TcamKernel kernel_request_ = TcamKernel::Auto;
+    TcamKernel kernel_ = TcamKernel::Scalar;
+    MatchFn match_ = nullptr;
+};
@@ -0,0 +1,178 @@
+/** *************************************************************/
+// @Name: TcamWriter.cpp
+// @Function: Buffered output for the SRGE / DIRPE / CGFE TCAM rule writers
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-26
+/************************************************************* */
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TcamWriter.hpp"
+
+// ===============================================================================
+// Module 1: Open / Close
+// ===============================================================================
+
+// At least MIN_BUFFER_SIZE so one field (pattern <= 128 + padding) always fits
+TcamWriter::TcamWriter(size_t buffer_size) : buf_(std::max(buffer_size, MIN_BUFFER_SIZE)) {}
+
+TcamWriter::~TcamWriter()
+{
+    if (fd_ >= 0)
+        close();
+}
+
+bool TcamWriter::open(const std::string &path)
+{
+    if (fd_ >= 0)
+        close();
+
+    stats_ = TcamWriteStats();
+    len_ = 0;
+    path_ = path;
+    start_ = std::chrono::steady_clock::now();
+
+    if (path.empty())
+    {
+        std::cout.flush(); // Keep ordering with earlier iostream output
+        fd_ = STDOUT_FILENO;
+        owns_fd_ = false;
+        stats_.ok = true;
+        return true;
+    }
+
+    // Create output directory if needed
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(parent, ec);
+        if (ec)
+        {
+            std::cerr << "[ERROR] Cannot create directory " << parent.string() << ": " << ec.message() << "\n";
+            return false;
+        }
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        std::cerr << "[ERROR] Cannot open output file: " << path << "\n";
+        return false;
+    }
+    owns_fd_ = true;
+    stats_.ok = true;
+    return true;
+}
+
+TcamWriteStats TcamWriter::close()
+{
+    if (fd_ < 0)
+        return stats_;
+
+    flush();
+    if (owns_fd_ && ::close(fd_) != 0)
+    {
+        std::cerr << "[ERROR] Failed to close output file: " << path_ << "\n";
+        stats_.ok = false;
+    }
+    fd_ = -1;
+    owns_fd_ = false;
+
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    return stats_;
+}
+
+// ===============================================================================
+// Module 2: Buffer Flush
+// ===============================================================================
+
+void TcamWriter::flush()
+{
+    if (len_ == 0)
+        return;
+    write_all(buf_.data(), len_);
+    len_ = 0;
+}
+
+void TcamWriter::write_all(const char *data, size_t n)
+{
+    if (fd_ < 0 || !stats_.ok)
+        return;
+
+    while (n > 0)
+    {
+        ssize_t w = ::write(fd_, data, n);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "[ERROR] Write failed on " << (path_.empty() ? "stdout" : path_) << "\n";
+            stats_.ok = false;
+            return;
+        }
+        data += w;
+        n -= (size_t)w;
+        stats_.bytes += (uint64_t)w;
+    }
+}
+
+// ===============================================================================
+// Module 3: Number Formatting
+// ===============================================================================
+
+void TcamWriter::put_uint(uint64_t v)
+{
+    char tmp[20];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    reserve(n);
+    while (n)
+        buf_[len_++] = tmp[--n];
+}
+
+void TcamWriter::put_int(int64_t v)
+{
+    if (v < 0)
+    {
+        put('-');
+        put_uint(0 - (uint64_t)v);
+        return;
+    }
+    put_uint((uint64_t)v);
+}
+
+void TcamWriter::put_ipv4(uint32_t ip)
+{
+    // Up to 3 digits per octet, written without going through put_uint
+    reserve(15);
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        unsigned octet = (ip >> shift) & 0xFF;
+        if (octet >= 100)
+            buf_[len_++] = (char)('0' + octet / 100);
+        if (octet >= 10)
+            buf_[len_++] = (char)('0' + octet / 10 % 10);
+        buf_[len_++] = (char)('0' + octet % 10);
+        if (shift)
+            buf_[len_++] = '.';
+    }
+}
+
+void TcamWriter::put_hex2(uint8_t v)
+{
+    static const char HEX[] = "0123456789abcdef";
+    reserve(2);
+    buf_[len_++] = HEX[v >> 4];
+    buf_[len_++] = HEX[v & 0xF];
+}
@@ -0,0 +1,149 @@
+/** *************************************************************/
+// @Name: TcamWriter.hpp
+// @Function: Buffered output for the SRGE / DIRPE / CGFE TCAM rule writers
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-26
+// @Description: Hand-rolled formatting into a reusable buffer, flushed with write(2)
+/************************************************************* */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Ternary.hpp"
+
+// ===============================================================================
+// Write Statistics
+// ===============================================================================
+
+struct TcamWriteStats
+{
+    uint64_t bytes = 0;   // Bytes handed to write(2)
+    double seconds = 0.0; // open() .. close(), formatting included
+    bool ok = false;      // File opened and every write succeeded
+
+    double mb_per_s() const { return seconds > 0.0 ? bytes / seconds / 1e6 : 0.0; }
+};
+
+// Output of one rule in a TCAM file (incremental reload bookkeeping)
+struct RuleOutputSize
+{
+    uint32_t bytes = 0;
+    uint32_t entries = 0;
+};
+
+// ===============================================================================
+// TcamWriter
+// ===============================================================================
+//
+// Entries are formatted straight into one buffer (default 4 MiB) that is
+// flushed with large write(2) calls whenever it fills. No iostream state, no
+// temporaries per field. Parent directories of the output path are created
+// with std::filesystem. An empty path writes to stdout.
+
+class TcamWriter
+{
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 4u << 20;
+    static constexpr size_t MIN_BUFFER_SIZE = 4096;
+
+    explicit TcamWriter(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~TcamWriter();
+
+    TcamWriter(const TcamWriter &) = delete;
+    TcamWriter &operator=(const TcamWriter &) = delete;
+
+    // Prints [ERROR] and returns false if the file cannot be created
+    bool open(const std::string &path);
+
+    // Flush, close and return the statistics of this file
+    TcamWriteStats close();
+
+    bool is_open() const { return fd_ >= 0; }
+
+    // Bytes produced since open(), buffered or written
+    uint64_t offset() const { return stats_.bytes + len_; }
+
+    // ---------------Formatting Primitives---------------------
+
+    void put(char ch)
+    {
+        if (len_ == buf_.size())
+            flush();
+        buf_[len_++] = ch;
+    }
+
+    void put(const char *s, size_t n)
+    {
+        if (len_ + n > buf_.size())
+        {
+            flush();
+            if (n > buf_.size())
+            {
+                write_all(s, n);
+                return;
+            }
+        }
+        std::memcpy(buf_.data() + len_, s, n);
+        len_ += n;
+    }
+
+    void put(const std::string &s) { put(s.data(), s.size()); }
+
+    template <size_t N>
+    void put_literal(const char (&s)[N]) { put(s, N - 1); }
+
+    void put_fill(char ch, size_t n)
+    {
+        while (n--)
+            put(ch);
+    }
+
+    void put_uint(uint64_t v);
+    void put_int(int64_t v);
+
+    // Dotted quad, e.g. 10.1.0.0
+    void put_ipv4(uint32_t ip);
+
+    // Two lowercase hex digits (no 0x prefix)
+    void put_hex2(uint8_t v);
+
+    // Pattern text, left-padded with '0' up to pad_to symbols
+    template <int N>
+    void put_pattern(const Ternary<N> &p, int pad_to = 0)
+    {
+        // (care, value) -> symbol; value is 0 under wildcards
+        static constexpr char SYMBOL[4] = {'*', '0', '*', '1'};
+
+        size_t pad = pad_to > p.width ? (size_t)(pad_to - p.width) : 0;
+        reserve(pad + p.width);
+        char *out = buf_.data() + len_;
+        for (size_t i = 0; i < pad; ++i)
+            *out++ = '0';
+        for (int bit = p.width - 1; bit >= 0; --bit)
+            *out++ = SYMBOL[((p.mask >> bit) & 1) | (((p.value >> bit) & 1) << 1)];
+        len_ += pad + p.width;
+    }
+
+private:
+    // Make room for n contiguous bytes (n must not exceed the buffer size)
+    void reserve(size_t n)
+    {
+        if (len_ + n > buf_.size())
+            flush();
+    }
+
+    void flush();
+    void write_all(const char *data, size_t n);
+
+    std::vector<char> buf_;
+    size_t len_ = 0;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    std::string path_;
+    TcamWriteStats stats_;
+    std::chrono::steady_clock::time_point start_;
+};
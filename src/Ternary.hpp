@@ -0,0 +1,205 @@
+/** *************************************************************/
+// @Name: Ternary.hpp
+// @Function: Packed value/mask ternary pattern shared by SRGE, DIRPE and CGFE
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-01-22
+// @Description: Fixed-capacity Ternary<N>; text form is produced only at output time
+/************************************************************* */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// ===============================================================================
+// Ternary<N>: up to N ternary symbols packed into two machine words
+// ===============================================================================
+//
+// Symbol layout follows the text form: symbol 0 (leftmost) is bit (width - 1),
+// the last symbol is bit 0.
+//   '0' -> mask = 1, value = 0
+//   '1' -> mask = 1, value = 1
+//   '*' -> mask = 0, value = 0
+//
+// A key k matches iff ((k ^ value) & mask) == 0.
+
+template <int N>
+struct Ternary
+{
+    static_assert(N > 0 && N <= 128, "Ternary<N> supports 1..128 symbols");
+
+    using word_t = typename std::conditional<(N <= 16), uint16_t,
+                   typename std::conditional<(N <= 32), uint32_t,
+                   typename std::conditional<(N <= 64), uint64_t, unsigned __int128>::type>::type>::type;
+
+    word_t value = 0;  // Bit values at care positions (0 under wildcards)
+    word_t mask = 0;   // 1 = care bit, 0 = wildcard '*'
+    uint8_t width = 0; // Number of symbols actually used (<= N)
+
+    static constexpr int capacity = N;
+
+    static constexpr word_t low_bits(int n)
+    {
+        return n >= (int)(8 * sizeof(word_t)) ? (word_t)~(word_t)0
+                                              : (word_t)(((word_t)1 << n) - 1);
+    }
+
+    // All-care pattern for a concrete key
+    static Ternary exact(word_t v, int w)
+    {
+        Ternary t;
+        t.width = (uint8_t)w;
+        t.mask = low_bits(w);
+        t.value = v & t.mask;
+        return t;
+    }
+
+    // All-wildcard pattern
+    static Ternary any(int w)
+    {
+        Ternary t;
+        t.width = (uint8_t)w;
+        return t;
+    }
+
+    // Build from masks of "always one" / "always zero" bits (SRGE hypercubes)
+    static Ternary from_masks(word_t v, word_t m, int w)
+    {
+        Ternary t;
+        t.width = (uint8_t)w;
+        t.mask = m & low_bits(w);
+        t.value = v & t.mask;
+        return t;
+    }
+
+    // Convert from another capacity (the pattern's width must fit in N)
+    template <int M>
+    static Ternary from(const Ternary<M> &o)
+    {
+        assert(o.width <= N && "pattern wider than Ternary capacity");
+        Ternary t;
+        t.width = o.width;
+        t.mask = (word_t)o.mask;
+        t.value = (word_t)o.value;
+        return t;
+    }
+
+    // Parse '0' / '1' / '*' text
+    static Ternary from_string(const std::string &s)
+    {
+        assert((int)s.size() <= N && "pattern wider than Ternary capacity");
+        Ternary t;
+        t.width = (uint8_t)s.size();
+        for (char ch : s)
+        {
+            t.value <<= 1;
+            t.mask <<= 1;
+            if (ch != '*')
+            {
+                t.mask |= 1;
+                t.value |= (ch == '1');
+            }
+        }
+        return t;
+    }
+
+    // n symbols (value/mask in the low n bits) placed in front of this pattern
+    Ternary prepend(word_t head_value, word_t head_mask, int n) const
+    {
+        Ternary t;
+        t.width = (uint8_t)(width + n);
+        t.mask = (word_t)((head_mask << width) | mask);
+        t.value = (word_t)((head_value << width) | value);
+        return t;
+    }
+
+    // head followed by this pattern
+    Ternary prepend(const Ternary &head) const { return prepend(head.value, head.mask, head.width); }
+
+    // Pattern without its first n symbols
+    Ternary drop_front(int n) const
+    {
+        Ternary t;
+        t.width = (uint8_t)(width - n);
+        t.mask = mask & low_bits(t.width);
+        t.value = value & low_bits(t.width);
+        return t;
+    }
+
+    // Symbol at text position pos (0 = leftmost)
+    char at(int pos) const
+    {
+        int bit = width - 1 - pos;
+        if (!((mask >> bit) & 1))
+            return '*';
+        return ((value >> bit) & 1) ? '1' : '0';
+    }
+
+    // Turn the symbol at text position pos into a wildcard
+    void set_wildcard(int pos)
+    {
+        word_t bit = (word_t)((word_t)1 << (width - 1 - pos));
+        mask &= (word_t)~bit;
+        value &= (word_t)~bit;
+    }
+
+    // Equal on every symbol except text position pos
+    bool equal_except(const Ternary &o, int pos) const
+    {
+        word_t keep = (word_t)~(word_t)((word_t)1 << (width - 1 - pos));
+        return width == o.width && (mask & keep) == (o.mask & keep) &&
+               (value & keep) == (o.value & keep);
+    }
+
+    bool matches(word_t key) const { return ((key ^ value) & mask) == 0; }
+
+    // Every key matched by o is also matched by *this
+    bool subsumes(const Ternary &o) const
+    {
+        return (mask & ~o.mask) == 0 && ((value ^ o.value) & mask) == 0;
+    }
+
+    int wildcard_count() const
+    {
+        int care = __builtin_popcountll((unsigned long long)mask);
+        if (sizeof(word_t) > 8)
+            care += __builtin_popcountll((unsigned long long)(mask >> 32 >> 32));
+        return width - care;
+    }
+
+    bool operator==(const Ternary &o) const
+    {
+        return width == o.width && mask == o.mask && value == o.value;
+    }
+    bool operator!=(const Ternary &o) const { return !(*this == o); }
+
+    // Append text form to out (no allocation beyond out's growth)
+    void append_to(std::string &out) const
+    {
+        for (int pos = 0; pos < width; ++pos)
+            out += at(pos);
+    }
+
+    std::string to_string() const
+    {
+        std::string s;
+        s.reserve(width);
+        append_to(s);
+        return s;
+    }
+};
+
+template <int N>
+inline std::ostream &operator<<(std::ostream &os, const Ternary<N> &t)
+{
+    return os << t.to_string();
+}
+
+// Fence (thermometer) encodings used by DIRPE and CGFE: a 16-bit port with
+// chunk width c encodes to (16 / c) * (2^c - 1) symbols, at most 60 for c = 4.
+// Wider values (e.g. CGFEEncoder<32, 4>) use Ternary<output_bits> directly.
+constexpr int FENCE_MAX_BITS = 64;
+using FencePattern = Ternary<FENCE_MAX_BITS>;
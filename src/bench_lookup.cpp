@@ -0,0 +1,655 @@
+/** *************************************************************/
+// @Name: bench_lookup.cpp
+// @Function: Trace-driven classification throughput benchmark for the software TCAM engines
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-06
+// @Description: Replays a packet header trace through every encoder's expanded table
+/************************************************************* */
+//
+// Usage: bench_lookup [options] [RULES_FILE...]   (default src/ACL_rules/acl_10k.rules)
+//   -n N               trace headers generated per rule file (default 100000)
+//   -s SEED            trace seed (default 1)
+//   -p PACKETS         packets replayed per run, the trace is repeated (default: trace size)
+//   -t THREADS         replay / encoding threads, 0 = all hardware threads (default 1)
+//   --trace FILE       replay a ClassBench trace file instead of generating one
+//   --save-trace FILE  write the generated trace (one rule file only)
+//   --corner P         probability that a field sits on a range end (default 0.75)
+//   --pareto-a A, --pareto-b B
+//                      burst length of repeated headers (default 1, 0.1; B = 0: no bursts)
+//   --enc LIST         srge,dirpe2,dirpe4,cgfe2,cgfe4 (default all)
+//   --engine LIST      linear,bitslice (default both)
+//   --kernel K         auto, scalar, avx2 or avx512 (default auto)
+//   --latency N        headers timed one by one for the percentiles (default 20000)
+//   --validate N       headers checked against the rule table (default 20000, 0 = off)
+//
+// Trace generation follows ClassBench trace_generator: pick a rule uniformly,
+// put every field on the low or high end of the rule's range (with
+// probability --corner, else uniform inside the range) and repeat the header
+// a Pareto(a, b) number of times. Most headers thus hit a rule boundary, where
+// range expansion produces the most entries.
+//
+// Per (rule file, encoding, engine) the benchmark reports
+//   - Mpps: classify_batch() over --packets headers (wall clock, all threads)
+//   - ns/packet p50 / p90 / p99 / p99.9 / max: classify() timed per header,
+//     clock overhead subtracted
+//   - entries touched per lookup (mean / p99): rows the first-match scan
+//     reads; for the bit-sliced engine all entries of the blocks it visits
+//   - hit rate
+//   - wrong: share of a sample of --validate headers, evenly spaced over the
+//     trace, whose first-match priority differs from a direct range match over
+//     the RuleTable (no match on either side counts too). Rows with any
+//     mismatch are flagged WRONG: their throughput is that of a wrong table.
+//     The hit column alone hides this, since a catch-all rule matches anyway.
+// Trace files use the ClassBench format: "src_ip dst_ip sport dport proto [filter]",
+// decimal, whitespace separated.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CGFE_code.hpp"
+#include "Chunk_code.hpp"
+#include "Gray_code.hpp"
+#include "Loader.hpp"
+#include "Parallel.hpp"
+#include "TcamBitSlice.hpp"
+#include "TcamLookup.hpp"
+
+using namespace std;
+
+// ===============================================================================
+// Module 1: Trace Generation / IO
+// ===============================================================================
+
+// splitmix64, as in gen_rules.cpp: the same seed gives the same trace everywhere
+class SplitMix64
+{
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state_;
+};
+
+struct TraceConfig
+{
+    size_t count = 100000;
+    uint64_t seed = 1;
+    double corner = 0.75;
+    double pareto_a = 1.0;
+    double pareto_b = 0.1;
+};
+
+// Corner (lo or hi) with probability `corner`, else uniform in [lo, hi]
+static uint32_t pick_field(SplitMix64 &rng, uint32_t lo, uint32_t hi, double corner)
+{
+    if (rng.unit() < corner)
+        return (rng.next() & 1) ? hi : lo;
+    return (uint32_t)(lo + rng.next() % ((uint64_t)hi - lo + 1));
+}
+
+// ClassBench burst length: ceil(b / u^(1/a)), u in (0, 1]
+static size_t pareto_copies(SplitMix64 &rng, double a, double b)
+{
+    if (b <= 0.0)
+        return 1;
+    double u = 1.0 - rng.unit();
+    double copies = ceil(b / pow(u, 1.0 / a));
+    return copies < 1.0 ? 1 : copies > 1e9 ? (size_t)1e9 : (size_t)copies;
+}
+
+// Headers plus the RuleTable row each one was drawn from (ClassBench filter id)
+static vector<PacketHeader> generate_trace(const RuleTable &rules, const TraceConfig &cfg,
+                                           vector<uint32_t> &origin)
+{
+    SplitMix64 rng(cfg.seed);
+    vector<PacketHeader> trace;
+    trace.reserve(cfg.count);
+    origin.clear();
+    origin.reserve(cfg.count);
+    while (trace.size() < cfg.count)
+    {
+        uint32_t r = (uint32_t)(rng.next() % rules.size());
+        PacketHeader pkt;
+        pkt.src_ip = pick_field(rng, rules.src_ip_lo[r], rules.src_ip_hi[r], cfg.corner);
+        pkt.dst_ip = pick_field(rng, rules.dst_ip_lo[r], rules.dst_ip_hi[r], cfg.corner);
+        pkt.src_port = (uint16_t)pick_field(rng, rules.src_port_lo[r], rules.src_port_hi[r], cfg.corner);
+        pkt.dst_port = (uint16_t)pick_field(rng, rules.dst_port_lo[r], rules.dst_port_hi[r], cfg.corner);
+        pkt.proto = (uint8_t)pick_field(rng, rules.proto_lo[r], rules.proto_hi[r], cfg.corner);
+
+        size_t copies = min(pareto_copies(rng, cfg.pareto_a, cfg.pareto_b), cfg.count - trace.size());
+        for (size_t i = 0; i < copies; ++i)
+        {
+            trace.push_back(pkt);
+            origin.push_back(r);
+        }
+    }
+    return trace;
+}
+
+static vector<PacketHeader> load_trace(const string &path)
+{
+    ifstream in(path);
+    if (!in)
+        throw runtime_error("cannot open trace file " + path);
+    vector<PacketHeader> trace;
+    string line;
+    size_t line_no = 0, skipped = 0;
+    while (getline(in, line))
+    {
+        ++line_no;
+        istringstream fields(line);
+        unsigned long long sip, dip, sp, dp, proto;
+        if (!(fields >> sip >> dip >> sp >> dp >> proto) || sip > UINT32_MAX || dip > UINT32_MAX ||
+            sp > 0xFFFF || dp > 0xFFFF || proto > 0xFF)
+        {
+            if (line.find_first_not_of(" \t\r") != string::npos && skipped++ < 5)
+                fprintf(stderr, "[WARN] %s:%zu: malformed trace line skipped\n", path.c_str(), line_no);
+            continue;
+        }
+        PacketHeader pkt;
+        pkt.src_ip = (uint32_t)sip;
+        pkt.dst_ip = (uint32_t)dip;
+        pkt.src_port = (uint16_t)sp;
+        pkt.dst_port = (uint16_t)dp;
+        pkt.proto = (uint8_t)proto;
+        trace.push_back(pkt);
+    }
+    if (skipped > 5)
+        fprintf(stderr, "[WARN] %s: %zu malformed lines skipped in total\n", path.c_str(), skipped);
+    return trace;
+}
+
+static bool save_trace(const string &path, const vector<PacketHeader> &trace, const vector<uint32_t> &origin)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f)
+    {
+        fprintf(stderr, "[ERROR] cannot create trace file %s\n", path.c_str());
+        return false;
+    }
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        const PacketHeader &p = trace[i];
+        fprintf(f, "%u\t%u\t%u\t%u\t%u\t%u\n", p.src_ip, p.dst_ip, (unsigned)p.src_port,
+                (unsigned)p.dst_port, (unsigned)p.proto, origin[i] + 1);
+    }
+    return fclose(f) == 0;
+}
+
+// ===============================================================================
+// Module 2: Measurement
+// ===============================================================================
+
+struct RunResult
+{
+    double mpps = 0;
+    double hit_rate = 0;
+    double ns[5] = {}; // p50, p90, p99, p99.9, max
+    double touched_mean = 0;
+    uint64_t touched_p99 = 0;
+    size_t validated = 0; // Sample headers checked against the rule table
+    size_t wrong = 0;     // ... whose first-match priority differed
+};
+
+constexpr size_t REPLAY_CHUNK = 4096; // Headers per parallel_for chunk
+
+static double percentile(const vector<double> &sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t)(q * (sorted.size() - 1) + 0.5);
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+// Cost of one steady_clock::now() pair, subtracted from the per-header times
+static double clock_overhead_ns()
+{
+    vector<double> d(10001);
+    for (double &x : d)
+    {
+        auto t0 = chrono::steady_clock::now();
+        auto t1 = chrono::steady_clock::now();
+        x = chrono::duration<double, nano>(t1 - t0).count();
+    }
+    sort(d.begin(), d.end());
+    return d[d.size() / 2];
+}
+
+// Touched(match) -> entries the lookup read
+template <typename Engine, typename Touched>
+static RunResult measure(const Engine &engine, const vector<PacketHeader> &trace, uint64_t packets,
+                         size_t latency_samples, double clock_ns, ThreadPool &pool, Touched touched)
+{
+    RunResult res;
+
+    // Throughput: the trace replayed in chunks, every thread on its own chunks
+    atomic<uint64_t> hits{0};
+    auto start = chrono::steady_clock::now();
+    pool.parallel_for(packets, REPLAY_CHUNK, [&](size_t begin, size_t end) {
+        TcamMatch out[REPLAY_CHUNK];
+        uint64_t chunk_hits = 0;
+        while (begin < end)
+        {
+            size_t at = begin % trace.size();
+            size_t n = min(end - begin, trace.size() - at);
+            for (size_t done = 0; done < n; done += REPLAY_CHUNK)
+            {
+                size_t m = min(n - done, REPLAY_CHUNK);
+                engine.classify_batch(trace.data() + at + done, m, out);
+                for (size_t i = 0; i < m; ++i)
+                    chunk_hits += (bool)out[i];
+            }
+            begin += n;
+        }
+        hits += chunk_hits;
+    });
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    res.mpps = secs > 0 ? packets / secs / 1e6 : 0;
+    res.hit_rate = packets ? (double)hits.load() / packets : 0;
+
+    // Latency and entries touched: header by header on this thread
+    size_t n = min(latency_samples, trace.size());
+    vector<double> ns(n);
+    vector<uint64_t> rows(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto t0 = chrono::steady_clock::now();
+        TcamMatch m = engine.classify(trace[i]);
+        auto t1 = chrono::steady_clock::now();
+        ns[i] = max(0.0, chrono::duration<double, nano>(t1 - t0).count() - clock_ns);
+        rows[i] = touched(m);
+    }
+    sort(ns.begin(), ns.end());
+    sort(rows.begin(), rows.end());
+    const double qs[4] = {0.50, 0.90, 0.99, 0.999};
+    for (int q = 0; q < 4; ++q)
+        res.ns[q] = percentile(ns, qs[q]);
+    res.ns[4] = n ? ns.back() : 0;
+    double sum = 0;
+    for (uint64_t r : rows)
+        sum += (double)r;
+    res.touched_mean = n ? sum / n : 0;
+    res.touched_p99 = n ? rows[min((size_t)(0.99 * (n - 1) + 0.5), n - 1)] : 0;
+    return res;
+}
+
+// ===============================================================================
+// Module 3: Validation
+// ===============================================================================
+
+constexpr uint32_t NO_RULE = UINT32_MAX;
+
+// Sample headers and the priority a correct classifier reports for each
+struct ValidationSample
+{
+    vector<PacketHeader> headers;
+    vector<uint32_t> priority; // Smallest priority of the rules containing the header, NO_RULE if none
+};
+
+// count headers evenly spaced over the trace, each matched against every rule's five ranges
+static ValidationSample reference_sample(const RuleTable &rules, const vector<PacketHeader> &trace,
+                                         size_t count, ThreadPool &pool)
+{
+    ValidationSample s;
+    count = min(count, trace.size());
+    s.headers.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        s.headers.push_back(trace[i * trace.size() / count]);
+    s.priority.assign(count, NO_RULE);
+
+    pool.parallel_for(count, 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const PacketHeader &p = s.headers[i];
+            uint32_t best = NO_RULE;
+            for (size_t r = 0; r < rules.size(); ++r)
+            {
+                if (rules.priority[r] < best &&
+                    p.src_ip >= rules.src_ip_lo[r] && p.src_ip <= rules.src_ip_hi[r] &&
+                    p.dst_ip >= rules.dst_ip_lo[r] && p.dst_ip <= rules.dst_ip_hi[r] &&
+                    p.src_port >= rules.src_port_lo[r] && p.src_port <= rules.src_port_hi[r] &&
+                    p.dst_port >= rules.dst_port_lo[r] && p.dst_port <= rules.dst_port_hi[r] &&
+                    p.proto >= rules.proto_lo[r] && p.proto <= rules.proto_hi[r])
+                {
+                    best = rules.priority[r];
+                }
+            }
+            s.priority[i] = best;
+        }
+    });
+    return s;
+}
+
+// Sample headers the engine's classify_batch() gets wrong
+template <typename Engine>
+static size_t count_mismatches(const Engine &engine, const ValidationSample &s)
+{
+    vector<TcamMatch> out(s.headers.size());
+    engine.classify_batch(s.headers.data(), s.headers.size(), out.data());
+    size_t wrong = 0;
+    for (size_t i = 0; i < out.size(); ++i)
+        wrong += (out[i] ? out[i].priority : NO_RULE) != s.priority[i];
+    return wrong;
+}
+
+// ===============================================================================
+// Module 4: Encodings
+// ===============================================================================
+
+struct EncodingSpec
+{
+    string name;
+    PortEncoding encoding;
+    int param; // DIRPE W / CGFE c
+};
+
+static const EncodingSpec ENCODINGS[] = {
+    {"srge", PortEncoding::SRGE, 0},
+    {"dirpe2", PortEncoding::DIRPE, 2},
+    {"dirpe4", PortEncoding::DIRPE, 4},
+    {"cgfe2", PortEncoding::CGFE, 2},
+    {"cgfe4", PortEncoding::CGFE, 4},
+};
+
+// Expand the port table with one encoder and load the joined rows
+static void load_encoding(SoftwareTcam &tcam, const EncodingSpec &spec, const PortTable &port_table,
+                          const IPTable &ip_table, ThreadPool &pool)
+{
+    switch (spec.encoding)
+    {
+    case PortEncoding::SRGE:
+        tcam.load(generate_tcam_entries(SRGE(port_table, pool)), ip_table);
+        break;
+    case PortEncoding::DIRPE:
+        tcam.load(generate_dirpe_tcam_entries(DIRPE(port_table, spec.param, pool)), ip_table, spec.param);
+        break;
+    case PortEncoding::CGFE:
+    {
+        CGFEConfig config{16, spec.param};
+        tcam.load(generate_cgfe_tcam_entries(CGFE_encode_ports(port_table, config, pool)), ip_table, config);
+        break;
+    }
+    }
+}
+
+static vector<string> split_list(const string &list)
+{
+    vector<string> items;
+    string item;
+    istringstream in(list);
+    while (getline(in, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// ===============================================================================
+// Module 5: Command Line
+// ===============================================================================
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n N] [-s SEED] [-p PACKETS] [-t THREADS] [--trace FILE] [--save-trace FILE]\n"
+            "          [--corner P] [--pareto-a A] [--pareto-b B] [--enc LIST] [--engine LIST]\n"
+            "          [--kernel auto|scalar|avx2|avx512] [--latency N] [--validate N] [RULES_FILE...]\n"
+            "See the header of bench_lookup.cpp.\n",
+            prog);
+}
+
+static void print_result(const string &enc, const string &engine, size_t entries, const RunResult &r)
+{
+    printf("%-7s %-9s %9zu %9.2f %8.0f %8.0f %8.0f %8.0f %9.0f %10.1f %9llu %6.1f%%", enc.c_str(),
+           engine.c_str(), entries, r.mpps, r.ns[0], r.ns[1], r.ns[2], r.ns[3], r.ns[4], r.touched_mean,
+           (unsigned long long)r.touched_p99, r.hit_rate * 100.0);
+    if (r.validated)
+        printf(" %7.3f%%%s\n", 100.0 * r.wrong / r.validated, r.wrong ? "  WRONG" : "");
+    else
+        printf(" %8s\n", "-");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    TraceConfig trace_cfg;
+    uint64_t packets = 0; // 0 = one pass over the trace
+    int threads = 1;
+    string trace_path, save_path;
+    string enc_list = "srge,dirpe2,dirpe4,cgfe2,cgfe4";
+    string engine_list = "linear,bitslice";
+    TcamKernel kernel = TcamKernel::Auto;
+    size_t latency_samples = 20000;
+    size_t validate_samples = 20000;
+    vector<string> rule_files;
+    vector<const EncodingSpec *> encodings;
+    bool run_linear = false, run_bitslice = false;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            string arg = argv[i];
+            if (arg == "-h" || arg == "--help")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+            if (arg[0] != '-')
+            {
+                rule_files.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc)
+                throw invalid_argument(arg + " requires a value");
+            const char *val = argv[++i];
+            if (arg == "-n")
+            {
+                long long n = atoll(val);
+                if (n < 1)
+                    throw invalid_argument("-n must be > 0");
+                trace_cfg.count = (size_t)n;
+            }
+            else if (arg == "-s" || arg == "--seed")
+                trace_cfg.seed = strtoull(val, nullptr, 0);
+            else if (arg == "-p" || arg == "--packets")
+            {
+                long long n = atoll(val);
+                if (n < 1)
+                    throw invalid_argument("-p must be > 0");
+                packets = (uint64_t)n;
+            }
+            else if (arg == "-t" || arg == "--threads")
+            {
+                threads = atoi(val);
+                if (threads < 0)
+                    throw invalid_argument("-t must be >= 0");
+            }
+            else if (arg == "--trace")
+                trace_path = val;
+            else if (arg == "--save-trace")
+                save_path = val;
+            else if (arg == "--corner")
+            {
+                trace_cfg.corner = atof(val);
+                if (!(trace_cfg.corner >= 0.0 && trace_cfg.corner <= 1.0))
+                    throw invalid_argument("--corner must be in [0, 1]");
+            }
+            else if (arg == "--pareto-a")
+            {
+                trace_cfg.pareto_a = atof(val);
+                if (!(trace_cfg.pareto_a > 0.0))
+                    throw invalid_argument("--pareto-a must be > 0");
+            }
+            else if (arg == "--pareto-b")
+            {
+                trace_cfg.pareto_b = atof(val);
+                if (!(trace_cfg.pareto_b >= 0.0))
+                    throw invalid_argument("--pareto-b must be >= 0");
+            }
+            else if (arg == "--enc")
+                enc_list = val;
+            else if (arg == "--engine")
+                engine_list = val;
+            else if (arg == "--kernel")
+            {
+                string k = val;
+                if (k == "auto")
+                    kernel = TcamKernel::Auto;
+                else if (k == "scalar")
+                    kernel = TcamKernel::Scalar;
+                else if (k == "avx2")
+                    kernel = TcamKernel::AVX2;
+                else if (k == "avx512")
+                    kernel = TcamKernel::AVX512;
+                else
+                    throw invalid_argument("unknown kernel " + k);
+            }
+            else if (arg == "--latency")
+                latency_samples = (size_t)max(0LL, atoll(val));
+            else if (arg == "--validate")
+                validate_samples = (size_t)max(0LL, atoll(val));
+            else
+                throw invalid_argument("unknown option " + arg);
+        }
+
+        for (const string &name : split_list(enc_list))
+        {
+            auto it = find_if(begin(ENCODINGS), end(ENCODINGS), [&](const EncodingSpec &e) { return e.name == name; });
+            if (it == end(ENCODINGS))
+                throw invalid_argument("unknown encoding " + name);
+            encodings.push_back(it);
+        }
+        for (const string &name : split_list(engine_list))
+        {
+            if (name == "linear")
+                run_linear = true;
+            else if (name == "bitslice")
+                run_bitslice = true;
+            else
+                throw invalid_argument("unknown engine " + name);
+        }
+        if (rule_files.empty())
+            rule_files.push_back("src/ACL_rules/acl_10k.rules");
+        if (!save_path.empty() && (rule_files.size() > 1 || !trace_path.empty()))
+            throw invalid_argument("--save-trace needs exactly one rules file and no --trace");
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "[ERROR] %s\n", e.what());
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    threads = resolve_thread_count(threads);
+    ThreadPool pool(threads);
+    double clock_ns = clock_overhead_ns();
+
+    vector<PacketHeader> loaded_trace;
+    if (!trace_path.empty())
+    {
+        try
+        {
+            loaded_trace = load_trace(trace_path);
+        }
+        catch (const std::exception &e)
+        {
+            fprintf(stderr, "[ERROR] %s\n", e.what());
+            return 1;
+        }
+        if (loaded_trace.empty())
+        {
+            fprintf(stderr, "[ERROR] trace %s has no headers\n", trace_path.c_str());
+            return 1;
+        }
+    }
+
+    printf("kernel %s, %d replay thread%s, clock overhead %.0f ns subtracted\n",
+           tcam_kernel_name(resolve_tcam_kernel(kernel)), threads, threads == 1 ? "" : "s", clock_ns);
+
+    for (const string &path : rule_files)
+    {
+        RuleTable rules;
+        IPTable ip_table;
+        PortTable port_table;
+        try
+        {
+            load_rules_from_file(path, rules, threads);
+        }
+        catch (const std::exception &e)
+        {
+            fprintf(stderr, "[ERROR] Failed to load rules: %s\n", e.what());
+            return 1;
+        }
+        if (rules.empty())
+        {
+            fprintf(stderr, "[WARN] %s has no rules, skipped\n", path.c_str());
+            continue;
+        }
+        split_rules(rules, ip_table, port_table);
+
+        vector<uint32_t> origin;
+        vector<PacketHeader> trace = trace_path.empty() ? generate_trace(rules, trace_cfg, origin) : loaded_trace;
+        if (!save_path.empty() && !save_trace(save_path, trace, origin))
+            return 1;
+        uint64_t replay = packets ? packets : trace.size();
+        ValidationSample reference = reference_sample(rules, trace, validate_samples, pool);
+
+        printf("\n%s: %zu rules, trace %zu headers (%s), %llu packets replayed\n", path.c_str(), rules.size(),
+               trace.size(), trace_path.empty() ? "generated" : trace_path.c_str(), (unsigned long long)replay);
+        printf("%-7s %-9s %9s %9s %8s %8s %8s %8s %9s %10s %9s %7s %8s\n", "enc", "engine", "entries", "Mpps",
+               "p50 ns", "p90 ns", "p99 ns", "p999 ns", "max ns", "touched", "touch99", "hit", "wrong");
+
+        for (const EncodingSpec *spec : encodings)
+        {
+            SoftwareTcam linear;
+            load_encoding(linear, *spec, port_table, ip_table, pool);
+            linear.set_kernel(kernel);
+            const size_t rows = linear.size();
+
+            if (run_linear)
+            {
+                RunResult r = measure(linear, trace, replay, latency_samples, clock_ns, pool,
+                                      [&](const TcamMatch &m) -> uint64_t { return m ? m.entry + 1ull : rows; });
+                r.validated = reference.headers.size();
+                r.wrong = count_mismatches(linear, reference);
+                print_result(spec->name, "linear", rows, r);
+            }
+            if (run_bitslice)
+            {
+                BitSlicedTcam sliced;
+                sliced.build(linear);
+                sliced.set_kernel(kernel);
+                const uint64_t block = BitSlicedTcam::BLOCK_ENTRIES;
+                RunResult r = measure(sliced, trace, replay, latency_samples, clock_ns, pool,
+                                      [&](const TcamMatch &m) -> uint64_t {
+                                          uint64_t end = m ? (m.entry / block + 1) * block : rows;
+                                          return min<uint64_t>(end, rows);
+                                      });
+                r.validated = reference.headers.size();
+                r.wrong = count_mismatches(sliced, reference);
+                print_result(spec->name, "bitslice", rows, r);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,497 @@
+/** *************************************************************/
+// @Name: gen_rules.cpp
+// @Function: Seeded ClassBench-style ACL generator in the Loader.cpp rule grammar
+// @Author: weijzh (weijzh@pcl.ac.cn)
+// @Created: 2026-02-03
+// @Description: Synthetic rule files (up to 10M+ rules) for scaling SRGE / DIRPE / CGFE
+/************************************************************* */
+//
+// Usage: gen_rules -n COUNT [-s SEED] [-o FILE] [--src-len SPEC] [--dst-len SPEC]
+//                  [--sport SPEC] [--dport SPEC] [--proto SPEC] [--actions SPEC]
+//                  [--sites N] [--tuple-reuse P]
+//
+// Every SPEC is a weighted list "value:weight,value:weight,...":
+//   --src-len / --dst-len  prefix lengths 0..32, e.g. "32:80,24:15,0:5"
+//   --sport / --dport      port classes: exact (common service port or uniform),
+//                          any (0 : 65535), high (1024 : 65535), low (0 : 1023),
+//                          range (arbitrary lo : hi, width log-uniform in 1..4096)
+//   --proto                tcp, udp, icmp, any (0x00/0x00) or a protocol number
+//   --actions              trailing action tokens (no whitespace)
+// Defaults follow the field statistics of ACL_rules/acl_10k.rules.
+//
+// Addresses are drawn from --sites /16 networks per direction, so prefixes of
+// different rules nest as in real policies; with probability --tuple-reuse a
+// rule repeats the IP pair of one of the last 64 rules (ACL rules cluster on
+// host pairs, which split_rules merges into one IP tuple).
+// The same seed and options always produce the same file.
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "TcamWriter.hpp"
+
+using namespace std;
+
+// ===============================================================================
+// Module 1: Random Source
+// ===============================================================================
+
+// splitmix64: fast, seedable, identical on every platform
+class SplitMix64
+{
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n) without division (Lemire's multiply-high)
+    uint32_t below(uint32_t n)
+    {
+        return (uint32_t)(((next() & 0xFFFFFFFFull) * n) >> 32);
+    }
+
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state_;
+};
+
+// ===============================================================================
+// Module 2: Weighted Choices
+// ===============================================================================
+
+template <typename T>
+struct Weighted
+{
+    vector<T> values;
+    vector<uint64_t> cumulative; // Running sum of the weights
+
+    void add(const T &v, uint64_t weight)
+    {
+        if (weight == 0)
+            return;
+        values.push_back(v);
+        cumulative.push_back((cumulative.empty() ? 0 : cumulative.back()) + weight);
+    }
+
+    const T &pick(SplitMix64 &rng) const
+    {
+        uint64_t x = rng.next() % cumulative.back();
+        size_t i = 0;
+        while (cumulative[i] <= x) // Lists are short; a scan beats a binary search
+            ++i;
+        return values[i];
+    }
+};
+
+enum class PortClass
+{
+    Exact,
+    Any,
+    High,
+    Low,
+    Range
+};
+
+struct Protocol
+{
+    uint8_t value;
+    uint8_t mask;
+};
+
+// "value:weight,..." -> (value text, weight) pairs; throws on malformed specs
+static vector<pair<string, uint64_t>> split_spec(const string &option, const string &spec)
+{
+    vector<pair<string, uint64_t>> items;
+    size_t pos = 0;
+    while (pos <= spec.size())
+    {
+        size_t comma = spec.find(',', pos);
+        if (comma == string::npos)
+            comma = spec.size();
+        string item = spec.substr(pos, comma - pos);
+        size_t colon = item.rfind(':');
+        char *end = nullptr;
+        unsigned long long w = colon == string::npos ? 0 : strtoull(item.c_str() + colon + 1, &end, 10);
+        if (colon == string::npos || colon == 0 || end == item.c_str() + colon + 1 || *end != '\0')
+            throw invalid_argument(option + ": expected value:weight, got \"" + item + "\"");
+        items.push_back({item.substr(0, colon), (uint64_t)w});
+        pos = comma + 1;
+    }
+    return items;
+}
+
+static Weighted<int> parse_prefix_lengths(const string &option, const string &spec)
+{
+    Weighted<int> w;
+    for (const auto &it : split_spec(option, spec))
+    {
+        int len = atoi(it.first.c_str());
+        if (it.first.find_first_not_of("0123456789") != string::npos || len > 32)
+            throw invalid_argument(option + ": prefix length must be 0..32, got " + it.first);
+        w.add(len, it.second);
+    }
+    if (w.values.empty())
+        throw invalid_argument(option + ": all weights are zero");
+    return w;
+}
+
+static Weighted<PortClass> parse_port_classes(const string &option, const string &spec)
+{
+    Weighted<PortClass> w;
+    for (const auto &it : split_spec(option, spec))
+    {
+        PortClass c;
+        if (it.first == "exact")
+            c = PortClass::Exact;
+        else if (it.first == "any")
+            c = PortClass::Any;
+        else if (it.first == "high")
+            c = PortClass::High;
+        else if (it.first == "low")
+            c = PortClass::Low;
+        else if (it.first == "range")
+            c = PortClass::Range;
+        else
+            throw invalid_argument(option + ": unknown port class " + it.first);
+        w.add(c, it.second);
+    }
+    if (w.values.empty())
+        throw invalid_argument(option + ": all weights are zero");
+    return w;
+}
+
+static Weighted<Protocol> parse_protocols(const string &option, const string &spec)
+{
+    Weighted<Protocol> w;
+    for (const auto &it : split_spec(option, spec))
+    {
+        Protocol p{0, 0xFF};
+        if (it.first == "tcp")
+            p.value = 0x06;
+        else if (it.first == "udp")
+            p.value = 0x11;
+        else if (it.first == "icmp")
+            p.value = 0x01;
+        else if (it.first == "any")
+            p.mask = 0x00;
+        else
+        {
+            char *end = nullptr;
+            unsigned long v = strtoul(it.first.c_str(), &end, 0);
+            if (*end != '\0' || v > 255)
+                throw invalid_argument(option + ": unknown protocol " + it.first);
+            p.value = (uint8_t)v;
+        }
+        w.add(p, it.second);
+    }
+    if (w.values.empty())
+        throw invalid_argument(option + ": all weights are zero");
+    return w;
+}
+
+static Weighted<string> parse_actions(const string &option, const string &spec)
+{
+    Weighted<string> w;
+    for (const auto &it : split_spec(option, spec))
+    {
+        if (it.first.find_first_of(" \t\r\n\v\f") != string::npos)
+            throw invalid_argument(option + ": action tokens cannot contain whitespace");
+        w.add(it.first, it.second);
+    }
+    if (w.values.empty())
+        throw invalid_argument(option + ": all weights are zero");
+    return w;
+}
+
+// ===============================================================================
+// Module 3: Field Generators
+// ===============================================================================
+
+// Service ports that dominate exact-match ACL entries
+static const uint16_t COMMON_PORTS[] = {
+    20, 21, 22, 23, 25, 53, 67, 69, 80, 110, 123, 135, 137, 139, 143, 161,
+    179, 389, 443, 445, 514, 636, 993, 995, 1433, 1521, 1526, 1723, 3306, 3389,
+    5060, 5432, 8080, 8443};
+
+struct GenConfig
+{
+    uint64_t count = 0;
+    uint64_t seed = 1;
+    string output; // empty: stdout
+    Weighted<int> src_len, dst_len;
+    Weighted<PortClass> sport, dport;
+    Weighted<Protocol> proto;
+    Weighted<string> actions;
+    uint32_t sites = 1024;
+    double tuple_reuse = 0.6;
+};
+
+struct IPPair
+{
+    uint32_t sip, dip;
+    uint8_t slen, dlen;
+};
+
+static inline uint32_t prefix_mask(int len)
+{
+    return len == 0 ? 0u : 0xFFFFFFFFu << (32 - len);
+}
+
+class RuleGenerator
+{
+public:
+    explicit RuleGenerator(const GenConfig &cfg) : cfg_(cfg), rng_(cfg.seed)
+    {
+        for (int dir = 0; dir < 2; ++dir)
+        {
+            sites_[dir].resize(cfg.sites);
+            for (uint32_t &s : sites_[dir])
+                s = (uint32_t)rng_.next() & 0xFFFF0000u;
+        }
+    }
+
+    IPPair ip_pair()
+    {
+        if (recent_count_ > 0 && rng_.unit() < cfg_.tuple_reuse)
+            return recent_[rng_.below(recent_count_)];
+
+        IPPair p;
+        p.slen = (uint8_t)cfg_.src_len.pick(rng_);
+        p.dlen = (uint8_t)cfg_.dst_len.pick(rng_);
+        p.sip = address(0) & prefix_mask(p.slen);
+        p.dip = address(1) & prefix_mask(p.dlen);
+
+        recent_[recent_next_] = p;
+        recent_next_ = (recent_next_ + 1) % RECENT;
+        if (recent_count_ < RECENT)
+            recent_count_++;
+        return p;
+    }
+
+    void port_range(const Weighted<PortClass> &classes, uint32_t &lo, uint32_t &hi)
+    {
+        switch (classes.pick(rng_))
+        {
+        case PortClass::Exact:
+            lo = rng_.unit() < 0.7 ? COMMON_PORTS[rng_.below(sizeof(COMMON_PORTS) / sizeof(COMMON_PORTS[0]))]
+                                   : rng_.below(65536);
+            hi = lo;
+            break;
+        case PortClass::Any:
+            lo = 0;
+            hi = 65535;
+            break;
+        case PortClass::High:
+            lo = 1024;
+            hi = 65535;
+            break;
+        case PortClass::Low:
+            lo = 0;
+            hi = 1023;
+            break;
+        case PortClass::Range:
+        {
+            uint32_t width = (uint32_t)std::exp(rng_.unit() * std::log(4096.0)); // 1..4096
+            lo = rng_.below(65536 - width);
+            hi = lo + width;
+            break;
+        }
+        }
+    }
+
+    SplitMix64 &rng() { return rng_; }
+
+private:
+    // A site /16 of this direction plus random host bits
+    uint32_t address(int dir)
+    {
+        return sites_[dir][rng_.below((uint32_t)sites_[dir].size())] | (rng_.below(65536));
+    }
+
+    static constexpr uint32_t RECENT = 64;
+
+    const GenConfig &cfg_;
+    SplitMix64 rng_;
+    vector<uint32_t> sites_[2];
+    IPPair recent_[RECENT];
+    uint32_t recent_count_ = 0;
+    uint32_t recent_next_ = 0;
+};
+
+// ===============================================================================
+// Module 4: Output
+// ===============================================================================
+
+// "0x06" with uppercase hex digits, as in the shipped rule files
+static void put_hex_byte(TcamWriter &out, uint8_t v)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+    char s[4] = {'0', 'x', HEX[v >> 4], HEX[v & 15]};
+    out.put(s, 4);
+}
+
+// One rule line: @sip/len\tdip/len\tsp_lo : sp_hi\tdp_lo : dp_hi\tproto/mask\taction
+static void generate_rules(const GenConfig &cfg, TcamWriter &out)
+{
+    RuleGenerator gen(cfg);
+    for (uint64_t i = 0; i < cfg.count; ++i)
+    {
+        IPPair ip = gen.ip_pair();
+        uint32_t sp_lo, sp_hi, dp_lo, dp_hi;
+        gen.port_range(cfg.sport, sp_lo, sp_hi);
+        gen.port_range(cfg.dport, dp_lo, dp_hi);
+        const Protocol &proto = cfg.proto.pick(gen.rng());
+        const string &action = cfg.actions.pick(gen.rng());
+
+        out.put('@');
+        out.put_ipv4(ip.sip);
+        out.put('/');
+        out.put_uint(ip.slen);
+        out.put('\t');
+        out.put_ipv4(ip.dip);
+        out.put('/');
+        out.put_uint(ip.dlen);
+        out.put('\t');
+        out.put_uint(sp_lo);
+        out.put_literal(" : ");
+        out.put_uint(sp_hi);
+        out.put('\t');
+        out.put_uint(dp_lo);
+        out.put_literal(" : ");
+        out.put_uint(dp_hi);
+        out.put('\t');
+        put_hex_byte(out, proto.value);
+        out.put('/');
+        put_hex_byte(out, proto.mask);
+        out.put('\t');
+        out.put(action);
+        out.put('\n');
+    }
+}
+
+// ===============================================================================
+// Module 5: Command Line
+// ===============================================================================
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -n COUNT [-s SEED] [-o FILE] [--src-len SPEC] [--dst-len SPEC]\n"
+            "          [--sport SPEC] [--dport SPEC] [--proto SPEC] [--actions SPEC]\n"
+            "          [--sites N] [--tuple-reuse P]\n"
+            "SPEC is \"value:weight,...\"; see the header of gen_rules.cpp.\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    GenConfig cfg;
+    string src_len = "32:80,23:8,31:6,30:3,24:1,8:1,0:1";
+    string dst_len = "32:79,22:6,30:4,31:3,26:2,24:2,16:1,8:1,0:2";
+    string sport = "any:96,high:2,exact:2";
+    string dport = "exact:67,range:15,any:14,high:3,low:1";
+    string proto = "tcp:91,udp:3,icmp:3,any:3";
+    string actions = "0x0000/0x0000:68,0x1000/0x1000:16,0x0000/0x0200:16";
+    bool have_count = false;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            string arg = argv[i];
+            if (arg == "-h" || arg == "--help")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+            if (i + 1 >= argc)
+                throw invalid_argument(arg + " requires a value");
+            const char *val = argv[++i];
+            if (arg == "-n" || arg == "--rules")
+            {
+                char *end = nullptr;
+                errno = 0;
+                cfg.count = strtoull(val, &end, 10);
+                if (*end != '\0' || errno || cfg.count > UINT32_MAX)
+                    throw invalid_argument("-n must be a rule count up to 4294967295");
+                have_count = true;
+            }
+            else if (arg == "-s" || arg == "--seed")
+                cfg.seed = strtoull(val, nullptr, 0);
+            else if (arg == "-o" || arg == "--output")
+                cfg.output = val;
+            else if (arg == "--src-len")
+                src_len = val;
+            else if (arg == "--dst-len")
+                dst_len = val;
+            else if (arg == "--sport")
+                sport = val;
+            else if (arg == "--dport")
+                dport = val;
+            else if (arg == "--proto")
+                proto = val;
+            else if (arg == "--actions")
+                actions = val;
+            else if (arg == "--sites")
+            {
+                long long n = atoll(val);
+                if (n < 1 || n > (1 << 24))
+                    throw invalid_argument("--sites must be 1..16777216");
+                cfg.sites = (uint32_t)n;
+            }
+            else if (arg == "--tuple-reuse")
+            {
+                cfg.tuple_reuse = atof(val);
+                if (!(cfg.tuple_reuse >= 0.0 && cfg.tuple_reuse <= 1.0))
+                    throw invalid_argument("--tuple-reuse must be in [0, 1]");
+            }
+            else
+                throw invalid_argument("unknown option " + arg);
+        }
+        if (!have_count)
+            throw invalid_argument("-n COUNT is required");
+
+        cfg.src_len = parse_prefix_lengths("--src-len", src_len);
+        cfg.dst_len = parse_prefix_lengths("--dst-len", dst_len);
+        cfg.sport = parse_port_classes("--sport", sport);
+        cfg.dport = parse_port_classes("--dport", dport);
+        cfg.proto = parse_protocols("--proto", proto);
+        cfg.actions = parse_actions("--actions", actions);
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "[ERROR] %s\n", e.what());
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    TcamWriter out;
+    if (!out.open(cfg.output))
+        return 1;
+    generate_rules(cfg, out);
+    TcamWriteStats st = out.close();
+    if (!st.ok)
+        return 1;
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "[SUCCESS] Generated %llu rules (%llu bytes) in %.2f ms, seed %llu\n",
+            (unsigned long long)cfg.count, (unsigned long long)st.bytes, ms,
+            (unsigned long long)cfg.seed);
+    return 0;
+}
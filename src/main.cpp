@@ -10,24 +10,173 @@
 #include "Gray_code.hpp"
 #include "Chunk_code.hpp"
 #include "CGFE_code.hpp"
+#include "Parallel.hpp"
+#include "Snapshot.hpp"
+#include "Reload.hpp"
 
 using namespace std;
 
-int main(int argc, char **argv)
+static double elapsed_ms(chrono::steady_clock::time_point since)
 {
-    // Parse command-line arguments
-    string rules_path = "src/ACL_rules/example.rules";
-    if (argc >= 2)
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+}
+
+// Port-table encoding time and thread count
+static void print_encode_time(double ms, int threads)
+{
+    cout << "  - Port encoding: " << fixed << setprecision(2) << ms << " ms on "
+         << threads << (threads == 1 ? " thread\n" : " threads\n");
+}
+
+// TCAM writer summary: bytes, time and throughput
+static void print_write_stats(const TcamWriteStats &st)
+{
+    cout << "[OUTPUT] Wrote " << st.bytes << " bytes in " << fixed << setprecision(2)
+         << st.seconds * 1000.0 << " ms (" << st.mb_per_s() << " MB/s)\n";
+}
+
+// Range intern table summary: how many port ranges were actually encoded
+static void print_intern_stats(const RangeInternStats &st)
+{
+    cout << "  - Distinct port ranges: " << st.distinct << " of " << st.lookups
+         << " (intern hit rate " << fixed << setprecision(1) << 100.0 * st.hit_rate() << "%)\n";
+}
+
+// Output location of a rules file: src/output/<rules base name>
+static string output_base(const string &rules_path)
+{
+    string base_name = rules_path.substr(rules_path.find_last_of("/") + 1);
+    base_name = base_name.substr(0, base_name.find_last_of("."));
+    return "src/output/" + base_name;
+}
+
+// Output file of one encoder: src/output/<rules base name>_<suffix>.txt
+static string output_path(const string &rules_path, const string &suffix)
+{
+    return output_base(rules_path) + "_" + suffix + ".txt";
+}
+
+// ===============================================================================
+// Streaming Mode
+// ===============================================================================
+//
+// Rules are read in batches of batch_rules; each batch goes through split ->
+// encode -> expand -> write before the next one is parsed, so peak memory is
+// bounded by the batch instead of the rule file. The range intern tables are
+// cleared after each batch, so ranges are only shared within a batch. The
+// three output files are identical to those of the whole-table pipeline.
+static int run_streaming(const string &rules_path, size_t batch_rules, ThreadPool &pool)
+{
+    const int threads = pool.size();
+    cout << "[STEP 1] Streaming rules from: " << rules_path
+         << " (batches of " << batch_rules << " rules)\n\n";
+
+    CGFEConfig cgfe_config;
+    cgfe_config.W = 16;
+    cgfe_config.c = 2;
+    const int chunk_width = 2;
+
+    string srge_file = output_path(rules_path, "SRGE");
+    string dirpe_file = output_path(rules_path, "DIRPE");
+    string cgfe_file = output_path(rules_path, "CGFE");
+    SRGETcamStream srge_out;
+    DIRPETcamStream dirpe_out;
+    CGFETcamStream cgfe_out;
+    if (!srge_out.open(srge_file) || !dirpe_out.open(dirpe_file) || !cgfe_out.open(cgfe_file, cgfe_config))
+    {
+        return 1;
+    }
+
+    size_t batches = 0;
+    uint64_t srge_entries = 0, dirpe_entries = 0, cgfe_entries = 0;
+    double encode_ms[3] = {0.0, 0.0, 0.0};
+    size_t rule_count = 0;
+    try
+    {
+        rule_count = stream_rules_from_file(rules_path, batch_rules, [&](const RuleTable &batch)
+        {
+            IPTable ip_table(batch);
+            PortTable port_table(batch, 0, (uint32_t)batch.size());
+            batches++;
+
+            auto start = chrono::steady_clock::now();
+            auto srge_tcam = generate_tcam_entries(SRGE(port_table, pool));
+            encode_ms[0] += elapsed_ms(start);
+            srge_out.write(srge_tcam, ip_table);
+            srge_entries += srge_tcam.size();
+
+            start = chrono::steady_clock::now();
+            auto dirpe_tcam = generate_dirpe_tcam_entries(DIRPE(port_table, chunk_width, pool));
+            encode_ms[1] += elapsed_ms(start);
+            dirpe_out.write(dirpe_tcam, ip_table);
+            dirpe_entries += dirpe_tcam.size();
+
+            start = chrono::steady_clock::now();
+            auto cgfe_tcam = generate_cgfe_tcam_entries(CGFE_encode_ports(port_table, cgfe_config, pool));
+            encode_ms[2] += elapsed_ms(start);
+            cgfe_out.write(cgfe_tcam, ip_table);
+            cgfe_entries += cgfe_tcam.size();
+
+            // The intern tables would otherwise keep every distinct range of the file,
+            // and the pool's threads their CGFE sub-range memos across batches
+            srge_intern_clear();
+            dirpe_intern_clear();
+            cgfe_intern_clear();
+            cgfe_cache_reset(cgfe_cache_stats().capacity);
+        });
+    }
+    catch (const std::exception &e)
+    {
+        cerr << "[ERROR] Failed to load rules: " << e.what() << endl;
+        return 1;
+    }
+
+    cout << "[SUCCESS] Streamed " << rule_count << " rules in " << batches << " batches\n\n";
+
+    const char *names[3] = {"SRGE", "DIRPE", "CGFE"};
+    const uint64_t entries[3] = {srge_entries, dirpe_entries, cgfe_entries};
+    const string files[3] = {srge_file, dirpe_file, cgfe_file};
+    const TcamWriteStats stats[3] = {srge_out.close(), dirpe_out.close(), cgfe_out.close()};
+    for (int i = 0; i < 3; ++i)
     {
-        rules_path = string(argv[1]);
+        cout << "[" << names[i] << "] Generated TCAM entries: " << entries[i] << "\n";
+        print_encode_time(encode_ms[i], threads);
+        print_write_stats(stats[i]);
+        cout << "[OUTPUT] TCAM rules saved to: " << files[i] << "\n\n";
     }
+    return 0;
+}
 
-    // Step 1: Load rules from file
-    cout << "[STEP 1] Loading rules from: " << rules_path << endl;
-    vector<Rule5D> rules;
+// ===============================================================================
+// Incremental Mode
+// ===============================================================================
+//
+// Only lines changed since the previous --incremental run are parsed and
+// encoded; the rest of each TCAM file is copied from the previous output.
+// The first run (or one after the outputs were rebuilt otherwise) encodes
+// every line. Each output gets a .delta file with the removed / added entries.
+static int run_incremental(const string &rules_path, ThreadPool &pool)
+{
+    ReloadConfig cfg;
+    cfg.output_file[RELOAD_SRGE] = output_path(rules_path, "SRGE");
+    cfg.output_file[RELOAD_DIRPE] = output_path(rules_path, "DIRPE");
+    cfg.output_file[RELOAD_CGFE] = output_path(rules_path, "CGFE");
+    cfg.state_file = output_base(rules_path) + ".state";
+    cfg.chunk_width = 2;
+    cfg.cgfe.W = 16;
+    cfg.cgfe.c = 2;
+    cfg.threads = pool.size();
+    cfg.pool = &pool;
+
+    cout << "[STEP 1] Incremental reload of: " << rules_path << endl;
+    auto start = chrono::steady_clock::now();
+    ReloadStats st;
     try
     {
-        load_rules_from_file(rules_path, rules);
+        if (!reload_tcam_outputs(rules_path, cfg, st))
+        {
+            return 1;
+        }
     }
     catch (const std::exception &e)
     {
@@ -35,13 +184,129 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    cout << "[SUCCESS] Loaded " << rules.size() << " rules\n\n";
+    cout << "[SUCCESS] " << (st.incremental ? "Incremental" : "Full (no usable state)") << " rebuild in "
+         << fixed << setprecision(2) << elapsed_ms(start) << " ms\n";
+    cout << "  - Lines: " << st.lines << " (" << st.reused << " reused, " << st.encoded
+         << " encoded, " << st.removed << " removed)\n\n";
+
+    const char *names[RELOAD_OUTPUTS] = {"SRGE", "DIRPE", "CGFE"};
+    for (int o = 0; o < RELOAD_OUTPUTS; ++o)
+    {
+        cout << "[" << names[o] << "] TCAM entries: " << st.entries[o] << " (-" << st.dropped[o]
+             << " +" << st.added[o] << ")\n";
+        print_write_stats(st.write[o]);
+        cout << "[OUTPUT] TCAM rules saved to: " << cfg.output_file[o] << "\n";
+        cout << "[OUTPUT] Delta saved to: " << delta_path_for(cfg.output_file[o]) << "\n\n";
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    // Parse command-line arguments: [rules_path] [--threads N] [--save-snapshot] [--stream BATCH] [--incremental]
+    string rules_path = "src/ACL_rules/example.rules";
+    int threads = 1; // 1 = serial, 0 = one per hardware thread
+    bool save_snapshot = false;
+    size_t stream_batch = 0; // 0 = whole-table pipeline
+    bool incremental = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--threads")
+        {
+            if (i + 1 >= argc)
+            {
+                cerr << "[ERROR] --threads requires a value\n";
+                return 1;
+            }
+            threads = atoi(argv[++i]);
+            if (threads < 0)
+            {
+                cerr << "[ERROR] --threads must be >= 0\n";
+                return 1;
+            }
+        }
+        else if (arg == "--save-snapshot")
+        {
+            save_snapshot = true;
+        }
+        else if (arg == "--incremental")
+        {
+            incremental = true;
+        }
+        else if (arg == "--stream")
+        {
+            long long batch = i + 1 < argc ? atoll(argv[++i]) : 0;
+            if (batch <= 0)
+            {
+                cerr << "[ERROR] --stream requires a batch size > 0\n";
+                return 1;
+            }
+            stream_batch = (size_t)batch;
+        }
+        else
+        {
+            rules_path = arg;
+        }
+    }
+    threads = resolve_thread_count(threads);
+    ThreadPool pool(threads); // Shared by every encoder call of this run
+
+    if (incremental)
+    {
+        return run_incremental(rules_path, pool);
+    }
+    if (stream_batch)
+    {
+        if (save_snapshot)
+        {
+            cerr << "[WARN] --save-snapshot is ignored in streaming mode\n";
+        }
+        return run_streaming(rules_path, stream_batch, pool);
+    }
+
+    // Step 1: a snapshot newer than the rules file replaces the text parse.
+    // Its columns and IP tuples are used in place, so it stays mapped for the run.
+    RuleTable rules;
+    IPTable ip_table;
+    PortTable port_table;
+    string snapshot_path = snapshot_path_for(rules_path);
+    RuleSnapshot snapshot;
+
+    if (!save_snapshot && snapshot_is_fresh(snapshot_path, rules_path) && snapshot.open(snapshot_path))
+    {
+        cout << "[STEP 1] Mapping rules from snapshot: " << snapshot_path << endl;
+        cout << "[SUCCESS] Mapped " << snapshot.size() << " rules\n\n";
+
+        // Step 2: IP tuples were merged when the snapshot was saved
+        cout << "[STEP 2] IP and Port tables from the snapshot (no merge)...\n";
+        split_rules(snapshot, ip_table, port_table);
+    }
+    else
+    {
+        // Step 1: Load rules from file
+        cout << "[STEP 1] Loading rules from: " << rules_path << endl;
+        try
+        {
+            load_rules_from_file(rules_path, rules, threads);
+        }
+        catch (const std::exception &e)
+        {
+            cerr << "[ERROR] Failed to load rules: " << e.what() << endl;
+            return 1;
+        }
+
+        cout << "[SUCCESS] Loaded " << rules.size() << " rules\n\n";
+
+        // Step 2: Split rules into IP and Port tables (views over the RuleTable)
+        cout << "[STEP 2] Splitting rules into IP and Port tables...\n";
+        split_rules(rules, ip_table, port_table);
 
-    // Step 2: Split rules into IP and Port tables
-    cout << "[STEP 2] Splitting rules into IP and Port tables...\n";
-    vector<IPRule> ip_table;
-    vector<PortRule> port_table;
-    split_rules(rules, ip_table, port_table);
+        if (save_snapshot && save_rule_snapshot(snapshot_path, rules, ip_table, rules_path))
+        {
+            cout << "[OUTPUT] Rule snapshot saved to: " << snapshot_path << "\n";
+        }
+    }
     cout << "[SUCCESS] IP table: " << ip_table.size() << " entries, "
          << "Port table: " << port_table.size() << " entries\n\n";
 
@@ -53,7 +318,9 @@ int main(int argc, char **argv)
     cout << "===============================================================================\n\n";
     cout << "[STEP 3] Applying SRGE Gray Code Encoding to Port ranges...\n\n";
 
-    auto gray_coded_ports = SRGE(port_table);
+    auto srge_start = chrono::steady_clock::now();
+    auto gray_coded_ports = SRGE(port_table, pool);
+    double srge_ms = elapsed_ms(srge_start);
     auto tcam_entries = generate_tcam_entries(gray_coded_ports);
 
     cout << "[SRGE Results]:\n\n";
@@ -62,15 +329,32 @@ int main(int argc, char **argv)
     cout << "  - Generated TCAM entries: " << tcam_entries.size() << "\n";
     cout << "  - Average expansion factor: "
          << fixed << setprecision(0)
-         << (double)tcam_entries.size() / port_table.size() << "x\n\n";
+         << (double)tcam_entries.size() / port_table.size() << "x\n";
 
-    // Extract base filename for output
-    string base_name = rules_path.substr(rules_path.find_last_of("/") + 1);
-    base_name = base_name.substr(0, base_name.find_last_of("."));
-    string output_file = "src/output/" + base_name + "_SRGE.txt";
+    // Recursion cost per range: about one call per emitted pattern, so it grows
+    // with the expansion (not O(bits^2); 1855 calls for 1025:65535)
+    uint32_t srge_max_calls = 0;
+    uint64_t srge_total_calls = 0;
+    for (const auto &gp : gray_coded_ports)
+    {
+        for (const SRGEResult *r : {gp.src_srge.get(), gp.dst_srge.get()})
+        {
+            srge_max_calls = max(srge_max_calls, r->recursion_calls);
+            srge_total_calls += r->recursion_calls;
+        }
+    }
+    cout << "  - SRGE recursion calls per range: max " << srge_max_calls
+         << ", avg " << setprecision(2)
+         << (gray_coded_ports.empty() ? 0.0 : (double)srge_total_calls / (2 * gray_coded_ports.size()))
+         << "\n";
+    print_encode_time(srge_ms, threads);
+    print_intern_stats(srge_intern_stats());
+    cout << "\n";
+
+    string output_file = output_path(rules_path, "SRGE");
 
     // Save TCAM rules to file
-    print_tcam_rules(tcam_entries, ip_table, output_file);
+    print_write_stats(print_tcam_rules(tcam_entries, ip_table, output_file));
     cout << "[OUTPUT] TCAM rules saved to: " << output_file << "\n";
 
     cout << "\nend\n";
@@ -85,7 +369,9 @@ int main(int argc, char **argv)
 
     // Encode ports using DIRPE with W=2 (chunk width = 2 bits)
     int chunk_width = 2;
-    auto dirpe_ports = DIRPE(port_table, chunk_width);
+    auto dirpe_start = chrono::steady_clock::now();
+    auto dirpe_ports = DIRPE(port_table, chunk_width, pool);
+    double dirpe_ms = elapsed_ms(dirpe_start);
     auto dirpe_tcam = generate_dirpe_tcam_entries(dirpe_ports);
 
     cout << "[DIRPE Results]:\n\n";
@@ -95,11 +381,14 @@ int main(int argc, char **argv)
     cout << "  - Chunk width (W): " << chunk_width << " bits\n";
     cout << "  - Average expansion factor: "
          << fixed << setprecision(0)
-         << (double)dirpe_tcam.size() / port_table.size() << "x\n\n";
+         << (double)dirpe_tcam.size() / port_table.size() << "x\n";
+    print_encode_time(dirpe_ms, threads);
+    print_intern_stats(dirpe_intern_stats());
+    cout << "\n";
 
     // Save DIRPE TCAM rules to file
-    string dirpe_output_file = "src/output/" + base_name + "_DIRPE.txt";
-    print_dirpe_tcam_rules(dirpe_tcam, ip_table, dirpe_output_file);
+    string dirpe_output_file = output_path(rules_path, "DIRPE");
+    print_write_stats(print_dirpe_tcam_rules(dirpe_tcam, ip_table, dirpe_output_file));
     cout << "[OUTPUT] DIRPE TCAM rules saved to: " << dirpe_output_file << "\n";
 
     cout << "\nend\n";
@@ -118,7 +407,9 @@ int main(int argc, char **argv)
     cgfe_config.c = 2;
 
     // Encode ports using CGFE
-    auto cgfe_ports = CGFE_encode_ports(port_table, cgfe_config);
+    auto cgfe_start = chrono::steady_clock::now();
+    auto cgfe_ports = CGFE_encode_ports(port_table, cgfe_config, pool);
+    double cgfe_ms = elapsed_ms(cgfe_start);
     auto cgfe_tcam = generate_cgfe_tcam_entries(cgfe_ports);
 
     cout << "[CGFE Results]:\n\n";
@@ -128,13 +419,22 @@ int main(int argc, char **argv)
     cout << "  - Bit width (W): " << cgfe_config.W << " bits\n";
     cout << "  - Chunk parameter (c): " << cgfe_config.c << " bits\n";
     cout << "  - Block size: 2^(" << cgfe_config.W << "-" << cgfe_config.c << ") = " << cgfe_config.block_size() << "\n";
+    cout << "  - Pattern width: " << cgfe_config.output_bits() << " bits\n";
     cout << "  - Average expansion factor: "
          << fixed << setprecision(2)
-         << (double)cgfe_tcam.size() / port_table.size() << "x\n\n";
+         << (double)cgfe_tcam.size() / port_table.size() << "x\n";
+    print_encode_time(cgfe_ms, threads);
+    print_intern_stats(cgfe_intern_stats());
+
+    CGFECacheStats cgfe_cache = cgfe_cache_stats();
+    cout << "  - Sub-range cache: " << cgfe_cache.hits << " hits, "
+         << cgfe_cache.misses << " misses (hit rate "
+         << setprecision(1) << 100.0 * cgfe_cache.hit_rate() << "%), "
+         << cgfe_cache.entries << " cached\n\n";
 
     // Save CGFE TCAM rules to file
-    string cgfe_output_file = "src/output/" + base_name + "_CGFE.txt";
-    print_cgfe_tcam_rules(cgfe_tcam, ip_table, cgfe_output_file);
+    string cgfe_output_file = output_path(rules_path, "CGFE");
+    print_write_stats(print_cgfe_tcam_rules(cgfe_tcam, ip_table, cgfe_config, cgfe_output_file));
     cout << "[OUTPUT] CGFE TCAM rules saved to: " << cgfe_output_file << "\n";
 
     cout << "\nend\n";